@@ -0,0 +1,139 @@
+/**
+ * @file c8/audio.c
+ *
+ * Sound synthesis for backends: the CHIP-8 buzzer and XO-CHIP audio patterns.
+ *
+ * Both are played from a 32-bit phase accumulator. For patterns, the top 7
+ * bits of the phase index the 128 samples of the pattern, so the step of a
+ * pitch is `rate * 2^25 / sample rate`. Steps are computed once for all 256
+ * pitches from a table of `2^(k/48)` in 16.16 fixed point.
+ */
+
+#include "audio.h"
+
+#include "common.h"
+
+#include <string.h>
+
+C8_STATIC void c8_audio_fill(C8_Audio*, int16_t*, int);
+
+/**
+ * @brief `2^(k/48)` in 16.16 fixed point, for k = 0 to 47
+ */
+C8_STATIC const uint32_t c8_pitchFractions[48] = {
+    65536,  66489,  67456,  68438,  69433,  70443,  71468,  72507,  73562,  74632,
+    75717,  76819,  77936,  79069,  80220,  81386,  82570,  83771,  84990,  86226,
+    87480,  88752,  90043,  91353,  92682,  94030,  95398,  96785,  98193,  99621,
+    101070, 102540, 104032, 105545, 107080, 108638, 110218, 111821, 113448, 115098,
+    116772, 118470, 120194, 121942, 123715, 125515, 127341, 129193,
+};
+
+/**
+ * @brief Set up `audio` to render at `rate` Hz, silent
+ *
+ * @param audio `C8_Audio` to initialize
+ * @param rate sample rate in Hz
+ */
+void c8_audio_init(C8_Audio* audio, int rate) {
+    memset(audio, 0, sizeof(C8_Audio));
+    audio->rate        = rate;
+    audio->state.pitch = C8_AUDIO_DEFAULT_PITCH;
+    audio->buzzerStep  = (uint32_t) (((uint64_t) C8_AUDIO_BUZZER_FREQ << 32) / rate);
+
+    for (int pitch = 0; pitch < 256; pitch++) {
+        /* 4000 * 2^((pitch - 64) / 48) = 4000 * 2^octave * 2^(k / 48) */
+        int      octave = (pitch + 32) / 48 - 2;
+        uint64_t hz     = 4000 * (uint64_t) c8_pitchFractions[(pitch + 32) % 48];
+        uint64_t step   = octave >= 0 ? (hz << (25 + octave)) : (hz << 25) >> -octave;
+
+        audio->steps[pitch] = (uint32_t) (step / 65536 / (uint64_t) rate);
+    }
+}
+
+/**
+ * @brief Queue `state` for the consumer (producer side)
+ *
+ * @param audio `C8_Audio` to push to
+ * @param state new state
+ * @param time when the sound changed, in seconds on the clock passed to `c8_audio_render`
+ *
+ * @return 0 if queued, 1 if the queue is full and `state` was dropped
+ */
+int c8_audio_push(C8_Audio* audio, const C8_AudioState* state, double time) {
+    uint32_t head = audio->head;
+    uint32_t slot = head & (C8_AUDIO_QUEUE_SIZE - 1);
+
+    if (head - __atomic_load_n(&audio->tail, __ATOMIC_ACQUIRE) == C8_AUDIO_QUEUE_SIZE) {
+        return 1;
+    }
+
+    audio->queue[slot] = *state;
+    audio->times[slot] = time;
+    __atomic_store_n(&audio->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Apply the queued states in order and render `n` samples (consumer side)
+ *
+ * The buffer is taken to end at `now`: a state pushed `d` seconds earlier takes
+ * effect `d * rate` samples before its end, or at its start if it is older than
+ * the whole buffer. Each state plays until the next one, so a play followed by a
+ * stop within one buffer still sounds.
+ *
+ * @param audio `C8_Audio` to render
+ * @param out where to store `n` signed 16-bit mono samples
+ * @param n number of samples
+ * @param now current time, on the clock passed to `c8_audio_push`
+ */
+void c8_audio_render(C8_Audio* audio, int16_t* out, int n, double now) {
+    uint32_t head = __atomic_load_n(&audio->head, __ATOMIC_ACQUIRE);
+    int      done = 0;
+
+    for (uint32_t tail = audio->tail; tail != head; tail++) {
+        uint32_t slot = tail & (C8_AUDIO_QUEUE_SIZE - 1);
+        double   ago  = (now - audio->times[slot]) * audio->rate;
+        int      at   = ago >= n ? 0 : ago <= 0 ? n : n - (int) (ago + 0.5);
+
+        if (at > done) {
+            c8_audio_fill(audio, out + done, at - done);
+            done = at;
+        }
+        audio->state = audio->queue[slot];
+    }
+    __atomic_store_n(&audio->tail, head, __ATOMIC_RELEASE);
+
+    c8_audio_fill(audio, out + done, n - done);
+}
+
+/**
+ * @brief Render `n` samples of the current state
+ *
+ * @param audio `C8_Audio` to render
+ * @param out where to store `n` signed 16-bit mono samples
+ * @param n number of samples
+ */
+C8_STATIC void c8_audio_fill(C8_Audio* audio, int16_t* out, int n) {
+    C8_AudioState* state = &audio->state;
+
+    if (!state->on) {
+        memset(out, 0, n * sizeof(int16_t));
+        return;
+    }
+
+    if (!state->patternSet) {
+        for (int i = 0; i < n; i++) {
+            out[i] = (audio->phase & 0x80000000u) ? -C8_AUDIO_VOLUME : C8_AUDIO_VOLUME;
+            audio->phase += audio->buzzerStep;
+        }
+        return;
+    }
+
+    uint32_t step = audio->steps[state->pitch];
+    for (int i = 0; i < n; i++) {
+        uint32_t bit = audio->phase >> 25;
+        int      set = (state->pattern[bit >> 3] >> (7 - (bit & 7))) & 1;
+        out[i]       = set ? C8_AUDIO_VOLUME : -C8_AUDIO_VOLUME;
+        audio->phase += step;
+    }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file c8/audio.h
+ *
+ * Sound synthesis for backends: the CHIP-8 buzzer and XO-CHIP audio patterns.
+ */
+
+#ifndef C8_AUDIO_H
+#define C8_AUDIO_H
+
+#include "chip8.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Frequency of the buzzer played without an XO-CHIP pattern, in Hz.
+ */
+#define C8_AUDIO_BUZZER_FREQ 440
+
+/**
+ * @brief Amplitude of the generated square waves.
+ */
+#define C8_AUDIO_VOLUME (INT16_MAX / 4)
+
+/**
+ * @brief Number of states `C8_Audio` can hold before the consumer catches up (power of 2).
+ */
+#define C8_AUDIO_QUEUE_SIZE 64
+
+/**
+  * @struct C8_AudioState
+  * @brief What the tone generator should play
+  */
+typedef struct {
+    uint8_t pattern[C8_AUDIO_PATTERN_SIZE]; //!< XO-CHIP pattern, 1 bit per sample, MSB first
+    uint8_t pitch; //!< Pattern playback rate, `4000*2^((pitch-64)/48)` Hz
+    uint8_t patternSet; //!< 1 to play `pattern`, 0 to play the buzzer
+    uint8_t on; //!< 1 while the sound timer is running
+} C8_AudioState;
+
+/**
+  * @struct C8_Audio
+  * @brief Tone generator fed through a lock-free single-producer queue
+  *
+  * The emulation thread pushes a new `C8_AudioState` whenever the sound
+  * changes, stamped with the time of the change, and the audio thread
+  * applies every queued state in order at its offset within the buffer it
+  * renders, so changes shorter than a buffer still play. Neither side ever
+  * blocks.
+  */
+typedef struct {
+    C8_AudioState queue[C8_AUDIO_QUEUE_SIZE]; //!< States pushed but not yet taken
+    double        times[C8_AUDIO_QUEUE_SIZE]; //!< When each queued state was pushed, in seconds
+    uint32_t      head; //!< Number of states pushed (written by the producer)
+    uint32_t      tail; //!< Number of states taken (written by the consumer)
+    C8_AudioState state; //!< State being played (consumer only)
+    uint32_t      phase; //!< Position in the pattern or buzzer period, a full one is 2^32
+    uint32_t      steps[256]; //!< Phase increment per sample of each pitch
+    uint32_t      buzzerStep; //!< Phase increment per sample of the buzzer
+    int           rate; //!< Sample rate in Hz
+} C8_Audio;
+
+void c8_audio_init(C8_Audio*, int);
+int  c8_audio_push(C8_Audio*, const C8_AudioState*, double);
+void c8_audio_render(C8_Audio*, int16_t*, int, double);
+
+#endif
@@ -0,0 +1,607 @@
+/**
+ * @file c8/capture.c
+ *
+ * Video capture of `C8_Display` frames to an animated GIF or a Y4M stream.
+ *
+ * `c8_capture_frame` only packs the frame into a ring buffer; a background
+ * thread does the encoding. When the encoder falls behind by
+ * `C8_CAPTURE_QUEUE_SIZE` frames, new frames are dropped instead of blocking
+ * the emulator. Each queued frame keeps its frame number, so the timing of
+ * the video stays right: GIF frames are shown for longer and Y4M frames are
+ * repeated.
+ *
+ * GIF frames only contain the rectangle that changed since the previous
+ * frame, and identical frames only extend the delay of the previous one.
+ */
+
+#include "capture.h"
+
+#include "common.h"
+
+#include "private/backend.h"
+#include "private/exception.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Number of pixels in a captured frame.
+ */
+#define C8_CAPTURE_PIXELS (C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT)
+
+/**
+ * @brief Convert a frame number to hundredths of a second, the GIF delay unit.
+ */
+#define C8_GIF_TIME(i) ((unsigned) ((uint64_t) (i) * 100 / C8_CAPTURE_FPS))
+
+/**
+ * @brief Shortest GIF delay; most viewers slow down anything shorter.
+ */
+#define C8_GIF_MIN_DELAY 2
+
+/**
+ * @brief Longest GIF delay before an unchanged frame is written again.
+ */
+#define C8_GIF_MAX_DELAY 60000
+
+/**
+ * @brief LZW minimum code size for a 2-color GIF (the smallest allowed).
+ */
+#define C8_GIF_MIN_CODE_SIZE 2
+
+/**
+ * @brief Number of LZW codes in a GIF.
+ */
+#define C8_GIF_MAX_CODES 4096
+
+/**
+  * @struct C8_CaptureEncoder
+  * @brief State of the encoder thread
+  */
+typedef struct {
+    C8_Capture* cap; //!< Capture being encoded
+    uint8_t     canvas[C8_CAPTURE_PIXELS]; //!< Latest frame, not yet written for GIF
+    uint8_t     written[C8_CAPTURE_PIXELS]; //!< Last frame written to the GIF
+    uint8_t     frame[C8_CAPTURE_PIXELS]; //!< Frame being encoded
+    uint8_t     rect[C8_CAPTURE_PIXELS]; //!< Changed rectangle of `canvas`
+    uint8_t     yuv[C8_CAPTURE_PIXELS * 3]; //!< Y4M planes of `canvas`
+    uint16_t    dict[C8_GIF_MAX_CODES][2]; //!< LZW code of (prefix, pixel), or 0
+    int         colors[2]; //!< Colors of `canvas`
+    int         writtenColors[2]; //!< Colors of `written`
+    int         globalColors[2]; //!< GIF global color table
+    unsigned    start; //!< Frame number of `canvas`
+    int         started; //!< 1 once the first frame has been encoded
+    int         hasWritten; //!< 1 once a GIF frame has been written
+} C8_CaptureEncoder;
+
+/**
+  * @struct C8_GifBits
+  * @brief LZW code stream split into GIF sub-blocks
+  */
+typedef struct {
+    FILE*    f; //!< Output file
+    uint8_t  block[255]; //!< Current sub-block
+    int      len; //!< Bytes in `block`
+    uint32_t bits; //!< Bits not yet in `block`
+    int      nbits; //!< Number of bits in `bits`
+} C8_GifBits;
+
+C8_STATIC int   c8_capture_backend_render(C8_Backend*, C8_Display*, int*);
+C8_STATIC void* c8_capture_encode(void*);
+C8_STATIC void  c8_capture_gif_finish(C8_CaptureEncoder*);
+C8_STATIC void  c8_capture_gif_frame(C8_CaptureEncoder*, const C8_CaptureFrame*);
+C8_STATIC void  c8_capture_gif_header(FILE*, const int*);
+C8_STATIC void  c8_capture_gif_lzw(C8_CaptureEncoder*, const uint8_t*, int);
+C8_STATIC void  c8_capture_gif_put(C8_GifBits*, int, int);
+C8_STATIC void  c8_capture_gif_write(C8_CaptureEncoder*, unsigned);
+C8_STATIC void  c8_capture_unpack(const C8_CaptureFrame*, uint8_t*);
+C8_STATIC void  c8_capture_y4m_frame(C8_CaptureEncoder*, const C8_CaptureFrame*);
+
+/**
+ * @brief Feed every frame rendered by `c8` to `cap`
+ *
+ * The current backend of `c8` keeps working: it is wrapped by one that
+ * queues each frame before passing it on, so backend-specific state (like
+ * `c8_offscreen`) must be set up before calling this. The wrapped backend is
+ * deinitialized along with `c8`'s, but `cap` must still be closed with
+ * `c8_capture_close`.
+ *
+ * @param c8 `C8` to capture
+ * @param cap `C8_Capture` to feed
+ *
+ * @return 0 if success, C8_GRAPHICS_EXCEPTION on failure
+ */
+int c8_capture_attach(C8* c8, C8_Capture* cap) {
+    const C8_Backend wrapper = {
+        .name   = "capture",
+        .render = c8_capture_backend_render,
+    };
+    return c8_wrap_backend(c8, &wrapper, cap);
+}
+
+/**
+ * @brief Encode the remaining frames, finish the file and free `cap`
+ *
+ * Must be called from the thread that calls `c8_capture_frame`, after the
+ * last frame.
+ *
+ * @param cap `C8_Capture` to close
+ *
+ * @return 0 if success, C8_IO_EXCEPTION if the video could not be written
+ */
+int c8_capture_close(C8_Capture* cap) {
+    int ret;
+
+    pthread_mutex_lock(&cap->lock);
+    cap->stopping = 1;
+    pthread_cond_signal(&cap->cond);
+    pthread_mutex_unlock(&cap->lock);
+    pthread_join(cap->thread, NULL);
+
+    ret = cap->error;
+    if ((cap->f == stdout ? fflush(cap->f) : fclose(cap->f)) != 0) {
+        ret = C8_IO_EXCEPTION;
+    }
+
+    if (ret) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to write capture");
+    }
+
+    pthread_cond_destroy(&cap->cond);
+    pthread_mutex_destroy(&cap->lock);
+    free(cap->queue);
+    free(cap);
+    return ret;
+}
+
+/**
+ * @brief Queue `display` for encoding
+ *
+ * This only copies the frame; it never waits for the encoder.
+ *
+ * @param cap `C8_Capture` to add the frame to
+ * @param display `C8_Display` to capture
+ * @param colors background and foreground colors
+ *
+ * @return 0 if the frame was queued, 1 if it was dropped
+ */
+int c8_capture_frame(C8_Capture* cap, const C8_Display* display, const int* colors) {
+    unsigned index = cap->frameCount++;
+    int      full;
+
+    pthread_mutex_lock(&cap->lock);
+    full = cap->head - cap->tail == C8_CAPTURE_QUEUE_SIZE;
+    pthread_mutex_unlock(&cap->lock);
+
+    if (full) {
+        cap->dropped++;
+        return 1;
+    }
+
+    /* Only the encoder reads this slot, and only once head moves past it */
+    C8_CaptureFrame* frame = &cap->queue[cap->head % C8_CAPTURE_QUEUE_SIZE];
+    c8_display_pack(display, frame->p);
+    frame->mode      = display->mode;
+    frame->colors[0] = colors[0];
+    frame->colors[1] = colors[1];
+    frame->index     = index;
+
+    pthread_mutex_lock(&cap->lock);
+    cap->head++;
+    pthread_cond_signal(&cap->cond);
+    pthread_mutex_unlock(&cap->lock);
+    return 0;
+}
+
+/**
+ * @brief Start capturing to `path`
+ *
+ * @param path file to write to, or "-" for stdout
+ * @param format `C8_CAPTURE_GIF` or `C8_CAPTURE_Y4M`
+ *
+ * @return the capture, or NULL on failure
+ */
+C8_Capture* c8_capture_open(const char* path, int format) {
+    C8_Capture* cap;
+
+    if (format != C8_CAPTURE_GIF && format != C8_CAPTURE_Y4M) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid capture format: %d", format);
+        return NULL;
+    }
+
+    cap = calloc(1, sizeof(C8_Capture));
+    if (!cap || !(cap->queue = malloc(C8_CAPTURE_QUEUE_SIZE * sizeof(C8_CaptureFrame)))) {
+        free(cap);
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to allocate capture");
+        return NULL;
+    }
+
+    cap->f = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+    if (!cap->f) {
+        free(cap->queue);
+        free(cap);
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Could not open %s", path);
+        return NULL;
+    }
+
+    cap->format = format;
+    pthread_mutex_init(&cap->lock, NULL);
+    pthread_cond_init(&cap->cond, NULL);
+    if (pthread_create(&cap->thread, NULL, c8_capture_encode, cap) != 0) {
+        pthread_cond_destroy(&cap->cond);
+        pthread_mutex_destroy(&cap->lock);
+        if (cap->f != stdout) {
+            fclose(cap->f);
+        }
+        free(cap->queue);
+        free(cap);
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to start capture thread");
+        return NULL;
+    }
+    return cap;
+}
+
+/**
+ * @brief Queue `display` and render it with the wrapped backend.
+ *
+ * @param backend the backend instance
+ * @param display `C8_Display` to render
+ * @param colors colors to render
+ * @return the return value of the wrapped backend's `render`
+ */
+C8_STATIC int c8_capture_backend_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    C8_BackendWrapper* ctx   = (C8_BackendWrapper*) backend->ctx;
+    C8_Backend*        inner = c8_wrapped_backend(backend);
+
+    c8_capture_frame((C8_Capture*) ctx->data, display, colors);
+    return inner->render(inner, display, colors);
+}
+
+/**
+ * @brief Encoder thread: encode queued frames until `c8_capture_close`
+ *
+ * @param arg the `C8_Capture`
+ *
+ * @return NULL
+ */
+C8_STATIC void* c8_capture_encode(void* arg) {
+    C8_Capture*        cap = (C8_Capture*) arg;
+    C8_CaptureEncoder* enc = calloc(1, sizeof(C8_CaptureEncoder));
+
+    if (!enc) {
+        cap->error = C8_IO_EXCEPTION;
+        return NULL;
+    }
+    enc->cap = cap;
+
+    if (cap->format == C8_CAPTURE_Y4M) {
+        fprintf(cap->f,
+                "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444 XCOLORRANGE=FULL\n",
+                C8_HIGH_DISPLAY_WIDTH,
+                C8_HIGH_DISPLAY_HEIGHT,
+                C8_CAPTURE_FPS);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&cap->lock);
+        while (cap->tail == cap->head && !cap->stopping) {
+            pthread_cond_wait(&cap->cond, &cap->lock);
+        }
+        if (cap->tail == cap->head) {
+            pthread_mutex_unlock(&cap->lock);
+            break;
+        }
+        pthread_mutex_unlock(&cap->lock);
+
+        const C8_CaptureFrame* frame = &cap->queue[cap->tail % C8_CAPTURE_QUEUE_SIZE];
+        if (cap->format == C8_CAPTURE_GIF) {
+            c8_capture_gif_frame(enc, frame);
+        } else {
+            c8_capture_y4m_frame(enc, frame);
+        }
+
+        pthread_mutex_lock(&cap->lock);
+        cap->tail++;
+        pthread_mutex_unlock(&cap->lock);
+    }
+
+    if (cap->format == C8_CAPTURE_GIF) {
+        c8_capture_gif_finish(enc);
+    }
+    if (ferror(cap->f)) {
+        cap->error = C8_IO_EXCEPTION;
+    }
+    free(enc);
+    return NULL;
+}
+
+/**
+ * @brief Write the last frame of the GIF and the trailer
+ *
+ * @param enc the encoder
+ */
+C8_STATIC void c8_capture_gif_finish(C8_CaptureEncoder* enc) {
+    static const int colors[2] = { 0x000000, 0xFFFFFF };
+
+    if (!enc->started) {
+        c8_capture_gif_header(enc->cap->f, colors);
+    } else {
+        unsigned delay = C8_GIF_TIME(enc->cap->frameCount) - C8_GIF_TIME(enc->start);
+        c8_capture_gif_write(enc, delay < C8_GIF_MIN_DELAY ? C8_GIF_MIN_DELAY : delay);
+    }
+    fputc(0x3B, enc->cap->f);
+}
+
+/**
+ * @brief Encode `frame` into the GIF
+ *
+ * The previous frame is only written once its delay is known, that is when
+ * a different frame arrives. Frames shown for less than `C8_GIF_MIN_DELAY`
+ * are replaced by the next one.
+ *
+ * @param enc the encoder
+ * @param frame frame to encode
+ */
+C8_STATIC void c8_capture_gif_frame(C8_CaptureEncoder* enc, const C8_CaptureFrame* frame) {
+    unsigned elapsed;
+    int      changed;
+
+    c8_capture_unpack(frame, enc->frame);
+    if (!enc->started) {
+        enc->globalColors[0] = frame->colors[0];
+        enc->globalColors[1] = frame->colors[1];
+        c8_capture_gif_header(enc->cap->f, enc->globalColors);
+        enc->started = 1;
+    } else {
+        elapsed = C8_GIF_TIME(frame->index) - C8_GIF_TIME(enc->start);
+        changed = memcmp(enc->frame, enc->canvas, C8_CAPTURE_PIXELS) != 0
+               || frame->colors[0] != enc->colors[0] || frame->colors[1] != enc->colors[1];
+
+        if (!changed && elapsed < C8_GIF_MAX_DELAY) {
+            return;
+        }
+
+        if (!changed || elapsed >= C8_GIF_MIN_DELAY) {
+            c8_capture_gif_write(enc, elapsed);
+            enc->start = frame->index;
+        }
+    }
+
+    memcpy(enc->canvas, enc->frame, C8_CAPTURE_PIXELS);
+    enc->colors[0] = frame->colors[0];
+    enc->colors[1] = frame->colors[1];
+}
+
+/**
+ * @brief Write the GIF header, with a 2-color global color table, and loop forever
+ *
+ * @param f output file
+ * @param colors global color table
+ */
+C8_STATIC void c8_capture_gif_header(FILE* f, const int* colors) {
+    uint8_t header[] = {
+        'G', 'I', 'F', '8', '9', 'a',
+        C8_HIGH_DISPLAY_WIDTH, 0, C8_HIGH_DISPLAY_HEIGHT, 0,
+        0x80, 0, 0,
+        (colors[0] >> 16) & 0xFF, (colors[0] >> 8) & 0xFF, colors[0] & 0xFF,
+        (colors[1] >> 16) & 0xFF, (colors[1] >> 8) & 0xFF, colors[1] & 0xFF,
+        0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0',
+        0x03, 0x01, 0x00, 0x00, 0x00,
+    };
+    fwrite(header, 1, sizeof(header), f);
+}
+
+/**
+ * @brief Write `n` pixels as GIF image data
+ *
+ * @param enc the encoder
+ * @param pixels pixels to write (0 or 1)
+ * @param n number of pixels
+ */
+C8_STATIC void c8_capture_gif_lzw(C8_CaptureEncoder* enc, const uint8_t* pixels, int n) {
+    C8_GifBits bits    = { .f = enc->cap->f };
+    const int  clear   = 1 << C8_GIF_MIN_CODE_SIZE;
+    int        size    = C8_GIF_MIN_CODE_SIZE + 1;
+    int        maxCode = clear + 1;
+    int        code    = pixels[0];
+
+    memset(enc->dict, 0, sizeof(enc->dict));
+    fputc(C8_GIF_MIN_CODE_SIZE, bits.f);
+    c8_capture_gif_put(&bits, clear, size);
+
+    for (int i = 1; i < n; i++) {
+        int p = pixels[i];
+        if (enc->dict[code][p]) {
+            code = enc->dict[code][p];
+            continue;
+        }
+
+        c8_capture_gif_put(&bits, code, size);
+        enc->dict[code][p] = ++maxCode;
+        if (maxCode >= (1 << size)) {
+            size++;
+        }
+        if (maxCode == C8_GIF_MAX_CODES - 1) {
+            c8_capture_gif_put(&bits, clear, size);
+            memset(enc->dict, 0, sizeof(enc->dict));
+            size    = C8_GIF_MIN_CODE_SIZE + 1;
+            maxCode = clear + 1;
+        }
+        code = p;
+    }
+
+    c8_capture_gif_put(&bits, code, size);
+    c8_capture_gif_put(&bits, clear, size);
+    c8_capture_gif_put(&bits, clear + 1, C8_GIF_MIN_CODE_SIZE + 1);
+
+    if (bits.nbits > 0) {
+        bits.block[bits.len++] = bits.bits & 0xFF;
+    }
+    if (bits.len > 0) {
+        fputc(bits.len, bits.f);
+        fwrite(bits.block, 1, bits.len, bits.f);
+    }
+    fputc(0, bits.f);
+}
+
+/**
+ * @brief Append an LZW code to `bits`, writing out full sub-blocks
+ *
+ * @param bits code stream
+ * @param code code to append
+ * @param size code size in bits
+ */
+C8_STATIC void c8_capture_gif_put(C8_GifBits* bits, int code, int size) {
+    bits->bits |= (uint32_t) code << bits->nbits;
+    bits->nbits += size;
+
+    while (bits->nbits >= 8) {
+        bits->block[bits->len++] = bits->bits & 0xFF;
+        bits->bits >>= 8;
+        bits->nbits -= 8;
+
+        if (bits->len == (int) sizeof(bits->block)) {
+            fputc(bits->len, bits->f);
+            fwrite(bits->block, 1, bits->len, bits->f);
+            bits->len = 0;
+        }
+    }
+}
+
+/**
+ * @brief Write `enc->canvas` as a GIF frame shown for `delay`
+ *
+ * Only the rectangle that differs from the previous GIF frame is stored,
+ * unless the colors changed.
+ *
+ * @param enc the encoder
+ * @param delay delay in hundredths of a second
+ */
+C8_STATIC void c8_capture_gif_write(C8_CaptureEncoder* enc, unsigned delay) {
+    FILE* f     = enc->cap->f;
+    int   local = enc->colors[0] != enc->globalColors[0] || enc->colors[1] != enc->globalColors[1];
+    int   x0    = 0;
+    int   y0    = 0;
+    int   x1    = C8_HIGH_DISPLAY_WIDTH - 1;
+    int   y1    = C8_HIGH_DISPLAY_HEIGHT - 1;
+    int   n     = 0;
+
+    if (enc->hasWritten && enc->colors[0] == enc->writtenColors[0]
+        && enc->colors[1] == enc->writtenColors[1]) {
+        x0 = C8_HIGH_DISPLAY_WIDTH;
+        y0 = C8_HIGH_DISPLAY_HEIGHT;
+        x1 = y1 = -1;
+        for (int y = 0; y < C8_HIGH_DISPLAY_HEIGHT; y++) {
+            for (int x = 0; x < C8_HIGH_DISPLAY_WIDTH; x++) {
+                int i = y * C8_HIGH_DISPLAY_WIDTH + x;
+                if (enc->canvas[i] != enc->written[i]) {
+                    x0 = x < x0 ? x : x0;
+                    x1 = x > x1 ? x : x1;
+                    y0 = y < y0 ? y : y0;
+                    y1 = y > y1 ? y : y1;
+                }
+            }
+        }
+
+        if (x1 < 0) {
+            /* Nothing changed, a frame still needs at least one pixel */
+            x0 = y0 = x1 = y1 = 0;
+        }
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            enc->rect[n++] = enc->canvas[y * C8_HIGH_DISPLAY_WIDTH + x];
+        }
+    }
+
+    int     w       = x1 - x0 + 1;
+    int     h       = y1 - y0 + 1;
+    uint8_t frame[] = {
+        0x21, 0xF9, 0x04, 0x04, delay & 0xFF, (delay >> 8) & 0xFF, 0x00, 0x00,
+        0x2C, x0, 0, y0, 0, w, 0, h, 0, local ? 0x80 : 0x00,
+    };
+    fwrite(frame, 1, sizeof(frame), f);
+
+    if (local) {
+        for (int i = 0; i < 2; i++) {
+            fputc((enc->colors[i] >> 16) & 0xFF, f);
+            fputc((enc->colors[i] >> 8) & 0xFF, f);
+            fputc(enc->colors[i] & 0xFF, f);
+        }
+    }
+    c8_capture_gif_lzw(enc, enc->rect, n);
+
+    memcpy(enc->written, enc->canvas, C8_CAPTURE_PIXELS);
+    enc->writtenColors[0] = enc->colors[0];
+    enc->writtenColors[1] = enc->colors[1];
+    enc->hasWritten       = 1;
+}
+
+/**
+ * @brief Unpack `frame` into one byte per pixel at high resolution
+ *
+ * @param frame frame to unpack
+ * @param out where to store `C8_CAPTURE_PIXELS` pixels
+ */
+C8_STATIC void c8_capture_unpack(const C8_CaptureFrame* frame, uint8_t* out) {
+    if (frame->mode != C8_DISPLAYMODE_LOW) {
+        for (int i = 0; i < C8_CAPTURE_PIXELS; i++) {
+            out[i] = (frame->p[i >> 3] >> (7 - (i & 7))) & 1;
+        }
+        return;
+    }
+
+    for (int y = 0; y < C8_LOW_DISPLAY_HEIGHT; y++) {
+        uint8_t* row = &out[y * 2 * C8_HIGH_DISPLAY_WIDTH];
+        for (int x = 0; x < C8_LOW_DISPLAY_WIDTH; x++) {
+            int i          = y * C8_LOW_DISPLAY_WIDTH + x;
+            row[x * 2]     = (frame->p[i >> 3] >> (7 - (i & 7))) & 1;
+            row[x * 2 + 1] = row[x * 2];
+        }
+        memcpy(row + C8_HIGH_DISPLAY_WIDTH, row, C8_HIGH_DISPLAY_WIDTH);
+    }
+}
+
+/**
+ * @brief Write `frame` to the Y4M stream
+ *
+ * The previous frame is repeated in place of dropped frames.
+ *
+ * @param enc the encoder
+ * @param frame frame to encode
+ */
+C8_STATIC void c8_capture_y4m_frame(C8_CaptureEncoder* enc, const C8_CaptureFrame* frame) {
+    FILE*   f = enc->cap->f;
+    uint8_t yuv[2][3];
+
+    for (; enc->started && enc->start + 1 < frame->index; enc->start++) {
+        fputs("FRAME\n", f);
+        fwrite(enc->yuv, 1, sizeof(enc->yuv), f);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        int r = (frame->colors[i] >> 16) & 0xFF;
+        int g = (frame->colors[i] >> 8) & 0xFF;
+        int b = frame->colors[i] & 0xFF;
+        int u = (-43 * r - 85 * g + 128 * b + 32896) >> 8;
+        int v = (128 * r - 107 * g - 21 * b + 32896) >> 8;
+
+        yuv[i][0] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+        yuv[i][1] = u > 0xFF ? 0xFF : u;
+        yuv[i][2] = v > 0xFF ? 0xFF : v;
+    }
+
+    c8_capture_unpack(frame, enc->canvas);
+    for (int plane = 0; plane < 3; plane++) {
+        uint8_t* out = &enc->yuv[plane * C8_CAPTURE_PIXELS];
+        for (int i = 0; i < C8_CAPTURE_PIXELS; i++) {
+            out[i] = yuv[enc->canvas[i]][plane];
+        }
+    }
+
+    fputs("FRAME\n", f);
+    fwrite(enc->yuv, 1, sizeof(enc->yuv), f);
+    enc->start   = frame->index;
+    enc->started = 1;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file c8/capture.h
+ *
+ * Video capture of `C8_Display` frames to an animated GIF or a Y4M stream.
+ */
+
+#ifndef C8_CAPTURE_H
+#define C8_CAPTURE_H
+
+#include "chip8.h"
+#include "graphics.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Animated GIF, only the changed rectangle of each frame is stored.
+ */
+#define C8_CAPTURE_GIF 0
+
+/**
+ * @brief Uncompressed YUV4MPEG2 (4:4:4), for piping into an external encoder.
+ */
+#define C8_CAPTURE_Y4M 1
+
+/**
+ * @brief Number of frames the encoder thread may fall behind before frames are dropped.
+ */
+#define C8_CAPTURE_QUEUE_SIZE 256
+
+/**
+ * @brief Frame rate of captured video.
+ */
+#define C8_CAPTURE_FPS 60
+
+/**
+  * @struct C8_CaptureFrame
+  * @brief A queued frame
+  */
+typedef struct {
+    uint8_t  p[C8_PACKED_DISPLAY_SIZE]; //!< Pixels, packed with `c8_display_pack`
+    uint8_t  mode; //!< Display mode of `p`
+    int      colors[2]; //!< Background and foreground colors
+    unsigned index; //!< Frame number, counting dropped frames
+} C8_CaptureFrame;
+
+/**
+  * @struct C8_Capture
+  * @brief A capture in progress
+  *
+  * Frames are added with `c8_capture_frame` and encoded on a background
+  * thread. Low-resolution frames are scaled up 2x so the video is always
+  * `C8_HIGH_DISPLAY_WIDTH` by `C8_HIGH_DISPLAY_HEIGHT`.
+  */
+typedef struct {
+    FILE*            f; //!< Output file
+    int              format; //!< `C8_CAPTURE_GIF` or `C8_CAPTURE_Y4M`
+    C8_CaptureFrame* queue; //!< Ring of `C8_CAPTURE_QUEUE_SIZE` frames
+    unsigned         head; //!< Number of frames queued
+    unsigned         tail; //!< Number of frames encoded
+    unsigned         frameCount; //!< Number of frames passed to `c8_capture_frame`
+    unsigned         dropped; //!< Number of frames dropped because the queue was full
+    int              stopping; //!< Set by `c8_capture_close` to stop the encoder
+    int              error; //!< Exception code raised by the encoder, or 0
+    pthread_t        thread; //!< Encoder thread
+    pthread_mutex_t  lock; //!< Protects `head`, `tail` and `stopping`
+    pthread_cond_t   cond; //!< Signalled when a frame is queued or `stopping` is set
+} C8_Capture;
+
+int         c8_capture_attach(C8*, C8_Capture*);
+int         c8_capture_close(C8_Capture*);
+int         c8_capture_frame(C8_Capture*, const C8_Display*, const int*);
+C8_Capture* c8_capture_open(const char*, int);
+
+#endif
@@ -9,12 +9,16 @@
 #include "common.h"
 #include "font.h"
 
+#include "private/backend.h"
 #include "private/debug.h"
 #include "private/exception.h"
 #include "private/instruction.h"
+#include "private/render.h"
 #include "private/util.h"
 
+#include <pthread.h>
 #include <signal.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,8 +27,42 @@
 
 #define C8_DEBUG(c) (c->flags & C8_FLAG_DEBUG)
 
-C8_STATIC double c8_get_time(void);
-C8_STATIC void   c8_handle_signal(int);
+/**
+  * @struct C8_SimulateArgs
+  * @brief Arguments of the emulation thread in `C8_FLAG_RENDER_THREAD` mode
+  */
+typedef struct {
+    C8*              c8;
+    C8_TripleBuffer* tb;
+    int              ret;
+} C8_SimulateArgs;
+
+C8_STATIC void  c8_apply_input(C8*, double);
+C8_STATIC void  c8_handle_signal(int);
+C8_STATIC int   c8_simulate_loop(C8*, C8_TripleBuffer*);
+C8_STATIC int   c8_simulate_threaded(C8*);
+C8_STATIC void* c8_simulate_worker(void*);
+C8_STATIC int   c8_step_cycles(const C8*, const C8_CycleModel*);
+
+/**
+ * @brief `C8` whose backend is deinitialized on SIGINT
+ */
+C8_STATIC C8* c8_signalC8;
+
+/**
+ * @brief Copy the execution state of `src` to `dst`
+ *
+ * Everything except the debug breakpoint map, the backend and the hooks is
+ * copied, which is less than half of `sizeof(C8)`. This is meant for
+ * branching a running `C8`, e.g. for search or speculative execution.
+ *
+ * @param dst where to copy to
+ * @param src `C8` to copy
+ */
+void c8_copy(C8* dst, const C8* src) {
+    memcpy(dst, src, offsetof(C8, breakpoints));
+    memcpy(&dst->colors, &src->colors, offsetof(C8, backend) - offsetof(C8, colors));
+}
 
 /**
  * @brief Deinitialize graphics and free c8
@@ -32,10 +70,61 @@ C8_STATIC void   c8_handle_signal(int);
  * @param c8 `C8` to deinitialize
  */
 void c8_deinit(C8* c8) {
-    c8_deinit_graphics();
+    c8_deinit_graphics(c8);
     free(c8);
 }
 
+/**
+ * @brief Get the length of one 60 Hz frame of `c8`
+ *
+ * With `C8_FLAG_CYCLES`, frames are budgeted in machine cycles of the
+ * interpreter `c8->mode` emulates, so an instruction takes as much of the
+ * frame as it did on that interpreter (a tall `DRW` more than an `ADD`).
+ * Otherwise, and for XO-CHIP which has no original hardware, every
+ * instruction costs 1 out of `C8_FRAME_INSTRUCTIONS(c8)`.
+ *
+ * @param c8 `C8` to look at
+ *
+ * @return cycles per frame
+ */
+int c8_frame_cycles(const C8* c8) {
+    const C8_CycleModel* model = c8_cycle_model(c8);
+
+    return model ? model->frame : C8_FRAME_INSTRUCTIONS(c8);
+}
+
+/**
+ * @brief Store the current state of `c8` as a reset template in `cfg`
+ *
+ * This should be called right after the ROM and fonts are loaded. Trailing
+ * zero bytes are not counted in `cfg->memUsed`, so `c8_reset` only has to copy
+ * the fonts and the ROM itself.
+ *
+ * @param c8 `C8` to take the template from
+ * @param cfg where to store the template
+ */
+void c8_get_config(const C8* c8, C8_Config* cfg) {
+    int used = C8_MEMSIZE;
+    while (used > 0 && c8->mem[used - 1] == 0) {
+        used--;
+    }
+
+    memcpy(cfg->mem, c8->mem, used);
+    memset(cfg->mem + used, 0, C8_MEMSIZE - used);
+    cfg->memUsed     = used;
+    cfg->flags       = c8->flags;
+    cfg->tickSpeed   = c8->tickSpeed;
+    cfg->pollRate    = c8->pollRate;
+    cfg->speed       = c8->speed;
+    cfg->frameSkip   = c8->frameSkip;
+    cfg->colors[0]   = c8->colors[0];
+    cfg->colors[1]   = c8->colors[1];
+    cfg->fonts[0]    = c8->fonts[0];
+    cfg->fonts[1]    = c8->fonts[1];
+    cfg->mode        = c8->mode;
+    cfg->displayMode = c8->display.mode;
+}
+
 /**
  * @brief Initialize and return a `C8` with the given flags
  *
@@ -56,6 +145,7 @@ C8* c8_init(const char* path, int flags) {
     C8* c8           = (C8*) calloc(1, sizeof(C8));
     c8->flags        = flags;
     c8->tickSpeed    = C8_TICK_SPEED;
+    c8->pitch        = C8_AUDIO_DEFAULT_PITCH;
     c8->colors[1]    = 0xFFFFFF;
     c8->display.mode = C8_DISPLAYMODE_LOW;
     c8->mode         = C8_MODE_CHIP8;
@@ -220,16 +310,154 @@ int c8_load_rom(C8* c8, const char* addr) {
     return 0;
 }
 
+/**
+ * @brief Restore `c8` to the pristine post-load image in `cfg`.
+ *
+ * This is a cheap alternative to `c8_deinit` followed by `c8_init` and
+ * `c8_load_rom`: nothing is allocated and the ROM file is not read again.
+ * Breakpoints are kept.
+ *
+ * @param c8 `C8` to reset
+ * @param cfg template created by `c8_get_config`
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION on error.
+ */
+int c8_reset(C8* c8, const C8_Config* cfg) {
+    if (!c8 || !cfg || cfg->memUsed > C8_MEMSIZE) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid reset template.");
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    memcpy(c8->mem, cfg->mem, cfg->memUsed);
+    memset(c8->mem + cfg->memUsed, 0, C8_MEMSIZE - cfg->memUsed);
+
+    /* R through patternSet (registers, stack, timers and audio) are contiguous */
+    memset(c8->R, 0, offsetof(C8, keys) - offsetof(C8, R));
+    __atomic_store_n(&c8->keys, 0, __ATOMIC_RELAXED);
+    memset(c8->display.p, 0, sizeof(c8->display.p));
+
+    c8->pc             = C8_PROG_START;
+    c8->pitch          = C8_AUDIO_DEFAULT_PITCH;
+    c8->VK             = 0;
+    c8->waitingForKey  = 0;
+    c8->waitingForDraw = 0;
+    c8->running        = 0;
+    c8->display.mode   = cfg->displayMode;
+    c8->flags          = cfg->flags;
+    c8->tickSpeed      = cfg->tickSpeed;
+    c8->pollRate       = cfg->pollRate;
+    c8->speed          = cfg->speed;
+    c8->frameSkip      = cfg->frameSkip;
+    c8->colors[0]      = cfg->colors[0];
+    c8->colors[1]      = cfg->colors[1];
+    c8->fonts[0]       = cfg->fonts[0];
+    c8->fonts[1]       = cfg->fonts[1];
+    c8->mode           = cfg->mode;
+    c8->frameStep      = 0;
+    c8->cycles         = 0;
+    c8->frameTime      = 0.0;
+    memset(&c8->input, 0, sizeof(c8->input));
+    return 0;
+}
+
+/**
+ * @brief Run one 60 Hz frame of `c8` without graphics or input.
+ *
+ * Executes instructions worth `c8_frame_cycles(c8)`, stopping early when
+ * `c8` starts waiting for the next frame, then decrements the timers and
+ * stops the tone if the sound timer ran out. While it runs,
+ * `c8->frameStep` is the number of cycles (or instructions) already run in
+ * the frame, so backends can place sound changes within it. `c8->running`
+ * must be set by the caller.
+ *
+ * The frame spans `c8->frameTime` to `c8->frameTime + 1/60`, which then
+ * moves on to the next frame. Events in `c8->input` are applied before the
+ * instruction whose share of the frame they fall in, so input replayed with
+ * times based on frame numbers gives the same run every time.
+ *
+ * @param c8 the `C8` to run
+ * @return 0 if success, exception code on failure
+ */
+int c8_run_frame(C8* c8) {
+    const C8_CycleModel* model  = c8_cycle_model(c8);
+    const double         frame  = 1.0 / 60.0;
+    int                  budget = c8_frame_cycles(c8);
+
+    for (c8->frameStep = 0; c8->frameStep < budget && c8->running;) {
+        c8_apply_input(c8, c8->frameTime + frame * c8->frameStep / budget);
+        if (c8->waitingForDraw) {
+            break;
+        }
+
+        c8->cycles = 0;
+        if (!c8->waitingForKey) {
+            int ret = c8_parse_instruction(c8);
+            if (ret < 0) {
+                C8_HOOK(c8, C8_HOOK_EXCEPTION, ret);
+                return ret;
+            }
+            c8->pc += ret;
+        }
+        c8->frameStep += c8_step_cycles(c8, model);
+    }
+
+    c8->frameStep = budget;
+    c8->frameTime += frame;
+    if (c8->dt > 0) {
+        c8->dt--;
+    }
+    if (c8->st > 0 && --c8->st == 0) {
+        C8_Backend* backend = C8_BACKEND(c8);
+        backend->sound_stop(backend);
+        C8_HOOK(c8, C8_HOOK_SOUND_STOP, 0);
+    }
+    c8->waitingForDraw = 0;
+    C8_HOOK(c8, C8_HOOK_FRAME, 0);
+    return 0;
+}
+
+/**
+ * @brief Set the callback of `c8` for a `C8_HOOK_*` event
+ *
+ * Hooks let a host react to the interpreter, e.g. render only after
+ * `C8_HOOK_DRAW` or start its own audio on `C8_HOOK_SOUND_START`, instead of
+ * checking the state of `c8` every frame. An event without a hook costs one
+ * branch. Hooks are kept by `c8_reset`, `c8_copy` and `c8_load_state`.
+ *
+ * @param c8 `C8` to set the hook of
+ * @param event `C8_HOOK_*` event
+ * @param hook callback, or NULL to remove it
+ * @param data user context passed to `hook`
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION if `event` is invalid
+ */
+int c8_set_hook(C8* c8, int event, C8_Hook hook, void* data) {
+    if (event < 0 || event >= C8_HOOK_COUNT) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid hook event: %d", event);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    c8->hooks.fn[event]   = hook;
+    c8->hooks.data[event] = data;
+    return 0;
+}
+
 /**
  * @brief Main interpreter simulation loop. Exits when `c8->running` is 0.
  *
+ * With `C8_FLAG_RENDER_THREAD`, instructions run on a new thread while the
+ * calling thread presents frames and polls input, so a slow backend `render`
+ * drops frames instead of slowing the machine down.
+ *
+ * `c8->speed` scales both the instruction rate and the 60 Hz timers. When it
+ * is `C8_SPEED_UNCAPPED`, or while `C8_KEY_FAST_FORWARD` is held, there is no
+ * waiting at all and only one frame in `c8->frameSkip` is rendered.
+ *
  * @param c8 the `C8` to simulate
  * @return 0 if success, exception code on failure
  */
 int c8_simulate(C8* c8) {
-    int debugRet;
     int ret;
-    int step = 1;
 
     srand(time(NULL));
 
@@ -240,29 +468,90 @@ int c8_simulate(C8* c8) {
         return ret;
     }
 
-    const double refresh_rate          = 1.0 / 60.0;
-    double       last                  = c8_get_time();
-    double       acc                   = 0.0;
-    int          instructions_executed = 0;
-    int          new_frame             = 0;
-
-    while (c8->running) {
-        double current = c8_get_time();
-        acc += current - last;
-        last = current;
+    c8_signalC8 = c8;
+    if (c8->flags & C8_FLAG_RENDER_THREAD) {
+        return c8_simulate_threaded(c8);
+    }
+    return c8_simulate_loop(c8, NULL);
+}
 
-        if (acc >= refresh_rate) {
-            new_frame = 1;
-            acc -= refresh_rate;
+/**
+ * @brief Run instructions, timers and frames until `c8->running` is 0
+ *
+ * @param c8 the `C8` to simulate
+ * @param tb where to publish frames and take released keys from, or NULL
+ * to render and poll input inline
+ *
+ * @return 0 if success, exception code on failure
+ */
+C8_STATIC int c8_simulate_loop(C8* c8, C8_TripleBuffer* tb) {
+    C8_Backend*          backend = C8_BACKEND(c8);
+    const C8_CycleModel* model   = c8_cycle_model(c8);
+    int                  debugRet;
+    int                  ret;
+    int                  step = 1;
+
+    const double refresh_rate    = 1.0 / 60.0;
+    const double poll_interval   = c8->pollRate > 0 ? 1.0 / c8->pollRate : 0.0;
+    const double poll_period     = poll_interval > 0.0 ? poll_interval : refresh_rate;
+    const int    frame_skip      = c8->frameSkip > 0 ? c8->frameSkip : C8_FRAME_SKIP;
+    double       last            = c8_input_time();
+    double       acc             = 0.0;
+    double       next_poll       = last;
+    double       owed            = 0.0;
+    int          cycles_executed = 0;
+    int          skipped         = 0;
+    int          new_frame       = 0;
+
+    while (__atomic_load_n(&c8->running, __ATOMIC_ACQUIRE)) {
+        double current  = c8_input_time();
+        int    speed    = c8->speed ? c8->speed : 100;
+        int    uncapped = C8_UNCAPPED(c8);
+
+        if (uncapped) {
+            /* Frames are counted in cycles, as in `c8_run_frame`, and
+             * waiting for a draw skips straight to the next one */
+            if (cycles_executed >= c8_frame_cycles(c8) || c8->waitingForDraw) {
+                new_frame       = 1;
+                cycles_executed = 0;
+            }
+            cycles_executed += c8_step_cycles(c8, model);
+        } else {
+            /* Both the instruction rate and the timer clock run at `speed` */
+            acc += (current - last) * speed / 100.0;
+            if (acc >= refresh_rate) {
+                new_frame = 1;
+                acc -= refresh_rate;
+            }
         }
+        last = current;
 
         if (c8->waitingForDraw && !new_frame) {
             continue;
         }
 
-        usleep(1000000 / c8->tickSpeed);
+        if (!uncapped) {
+            /* Wait for as long as the last instruction took. A cycle is only
+             * microseconds, so waits are saved up to a millisecond or more. */
+            long per_second = model ? 60L * model->frame : c8->tickSpeed;
 
-        int t = c8_tick(c8->key);
+            owed += 100000000.0 * c8_step_cycles(c8, model) / ((double) per_second * speed);
+            if (owed >= 1000.0) {
+                usleep((useconds_t) owed);
+                owed = 0.0;
+            }
+        }
+
+        /* Polling the host is much slower than an instruction, so it is done
+         * once per frame (or `pollRate` times per second) rather than every
+         * iteration. Keys in between are those of the last poll. */
+        int t = -1;
+        if (tb) {
+            t = c8_triple_buffer_take_key(tb);
+        } else if (poll_interval > 0.0 || uncapped ? current >= next_poll : new_frame) {
+            t         = backend->tick(backend, &c8->keys);
+            next_poll = current + poll_period;
+        }
 
         if (t == -2) {
             /* Quit */
@@ -270,6 +559,11 @@ int c8_simulate(C8* c8) {
             continue;
         }
 
+        /* Timestamped events arrive in batches, one poll apart, and are
+         * applied as soon as they arrive. A key that went down and up within
+         * one batch still stays down for one instruction (see `c8_apply_input`). */
+        c8_apply_input(c8, current);
+
         if (new_frame) {
             /* Update timers and draw */
             if (c8->dt > 0) {
@@ -280,25 +574,35 @@ int c8_simulate(C8* c8) {
                 c8->st--;
 
                 if (c8->st == 0) {
-                    c8_sound_stop();
+                    backend->sound_stop(backend);
+                    C8_HOOK(c8, C8_HOOK_SOUND_STOP, 0);
                 }
             }
-
-            if (c8_render(&c8->display, c8->colors) < 0) {
-                return C8_GRAPHICS_EXCEPTION;
+            C8_HOOK(c8, C8_HOOK_FRAME, 0);
+
+            /* Uncapped frames come faster than they could be shown */
+            if (!uncapped || ++skipped >= frame_skip) {
+                skipped = 0;
+                if (tb) {
+                    c8_triple_buffer_publish(tb, &c8->display);
+                } else if (backend->render(backend, &c8->display, c8->colors) < 0) {
+                    C8_HOOK(c8, C8_HOOK_EXCEPTION, C8_GRAPHICS_EXCEPTION);
+                    return C8_GRAPHICS_EXCEPTION;
+                }
             }
 
             c8->waitingForDraw = 0;
             new_frame          = 0;
         }
 
-        if (c8->key[16]) {
+        uint32_t keys = __atomic_load_n(&c8->keys, __ATOMIC_RELAXED);
+        if (keys & C8_KEY_BIT(16)) {
             /* Enter debug mode */
             c8->flags |= C8_FLAG_DEBUG;
             step = 1;
         }
 
-        if (c8->key[17]) {
+        if (keys & C8_KEY_BIT(17)) {
             /* Exit debug mode */
             if (C8_DEBUG(c8)) {
                 c8->flags ^= C8_FLAG_DEBUG;
@@ -325,11 +629,13 @@ int c8_simulate(C8* c8) {
             c8->waitingForKey = 0;
         }
 
+        c8->cycles = 0;
         if (!c8->waitingForKey) {
             /* Not waiting for key, parse next instruction */
             ret = c8_parse_instruction(c8);
 
             if (ret < 0) {
+                C8_HOOK(c8, C8_HOOK_EXCEPTION, ret);
                 return ret;
             }
 
@@ -339,6 +645,49 @@ int c8_simulate(C8* c8) {
     return 0;
 }
 
+/**
+ * @brief Run `c8_simulate_loop` on a new thread and render on this one
+ *
+ * @param c8 the `C8` to simulate
+ * @return 0 if success, exception code on failure
+ */
+C8_STATIC int c8_simulate_threaded(C8* c8) {
+    C8_SimulateArgs args = { c8, NULL, 0 };
+    pthread_t       tid;
+    int             ret;
+
+    if (!(args.tb = malloc(sizeof(C8_TripleBuffer)))) {
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION, "Failed to allocate frame buffers");
+        return C8_INVALID_STATE_EXCEPTION;
+    }
+    c8_triple_buffer_init(args.tb);
+
+    if (pthread_create(&tid, NULL, c8_simulate_worker, &args) != 0) {
+        free(args.tb);
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION, "Failed to start emulation thread");
+        return C8_INVALID_STATE_EXCEPTION;
+    }
+
+    ret = c8_render_loop(c8, args.tb);
+    __atomic_store_n(&c8->running, 0, __ATOMIC_RELEASE);
+    pthread_join(tid, NULL);
+    free(args.tb);
+    return ret < 0 ? ret : args.ret;
+}
+
+/**
+ * @brief Emulation thread entry point
+ *
+ * @param arg `C8_SimulateArgs`
+ * @return NULL
+ */
+C8_STATIC void* c8_simulate_worker(void* arg) {
+    C8_SimulateArgs* args = (C8_SimulateArgs*) arg;
+    args->ret             = c8_simulate_loop(args->c8, args->tb);
+    __atomic_store_n(&args->c8->running, 0, __ATOMIC_RELEASE);
+    return NULL;
+}
+
 /**
  * @brief Validate the state of the chip8 emulator.
  *
@@ -366,6 +715,30 @@ int c8_validate(const C8* c8) {
         return C8_INVALID_STATE_EXCEPTION;
     }
 
+    if (c8->pollRate < 0) {
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION,
+                     "Input poll rate cannot be negative: pollRate=%d",
+                     c8->pollRate)
+        return C8_INVALID_STATE_EXCEPTION;
+    }
+
+    if (c8->speed != 0 && c8->speed != C8_SPEED_UNCAPPED
+        && (c8->speed < C8_SPEED_MIN || c8->speed > C8_SPEED_MAX)) {
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION,
+                     "Speed out of bounds (%d-%d%%): speed=%d",
+                     C8_SPEED_MIN,
+                     C8_SPEED_MAX,
+                     c8->speed)
+        return C8_INVALID_STATE_EXCEPTION;
+    }
+
+    if (c8->frameSkip < 0) {
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION,
+                     "Frame skip cannot be negative: frameSkip=%d",
+                     c8->frameSkip)
+        return C8_INVALID_STATE_EXCEPTION;
+    }
+
     if (c8->VK < 0 || c8->VK >= 16) {
         C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION, "VK out of bounds (0x0-0xF): VK=0x%X", c8->VK)
         return C8_INVALID_STATE_EXCEPTION;
@@ -390,13 +763,58 @@ int c8_validate(const C8* c8) {
  */
 const char*      c8_version(void) { return C8_VERSION; }
 
-C8_STATIC double c8_get_time(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    return ts.tv_sec + ts.tv_nsec * 1e-9;
+/**
+ * @brief Apply the queued key events of `c8` that happened up to `until`
+ *
+ * A key release while `c8` waits in `LD Vx, K` completes it, and no more
+ * events are applied until the next instruction, so that every release in
+ * a quick sequence is seen by the program. Likewise, a key changes at most
+ * once per call, so a tap that was polled late, with its press and release
+ * in one batch, is still seen by the next instruction.
+ *
+ * @param c8 `C8` to apply events to
+ * @param until time of the instruction about to run
+ */
+C8_STATIC void c8_apply_input(C8* c8, double until) {
+    const C8_InputEvent* e;
+    uint32_t             changed = 0;
+
+    while ((e = c8_input_peek(&c8->input)) && e->time <= until) {
+        int completesWait = !e->pressed && c8->waitingForKey;
+
+        if (changed & C8_KEY_BIT(e->key)) {
+            break;
+        }
+        changed |= C8_KEY_BIT(e->key);
+
+        c8_input_set_key(&c8->keys, e->key, e->pressed);
+        if (completesWait) {
+            c8->V[c8->VK]     = e->key;
+            c8->waitingForKey = 0;
+        }
+        c8_input_pop(&c8->input);
+
+        if (completesWait) {
+            break;
+        }
+    }
 }
 
 C8_STATIC void c8_handle_signal(int sig) {
-    c8_deinit_graphics();
+    if (c8_signalC8) {
+        c8_deinit_graphics(c8_signalC8);
+    }
     exit(0);
 }
+
+/**
+ * @brief Get the cycles the last step of `c8` took
+ *
+ * @param c8 `C8` that just ran an instruction, or waited for a key
+ * @param model `c8_cycle_model(c8)`
+ *
+ * @return `c8->cycles` when timed by `model`, else 1
+ */
+C8_STATIC int c8_step_cycles(const C8* c8, const C8_CycleModel* model) {
+    return model && c8->cycles > 0 ? c8->cycles : 1;
+}
@@ -9,6 +9,7 @@
 
 #include "common.h"
 #include "graphics.h"
+#include "input.h"
 
 #include <stdint.h>
 
@@ -17,11 +18,54 @@
  */
 #define C8_TICK_SPEED (12 * 60)
 
+/**
+ * @brief Number of instructions `c8_run_frame` runs per frame
+ */
+#define C8_FRAME_INSTRUCTIONS(c8) ((c8)->tickSpeed / 60 > 0 ? (c8)->tickSpeed / 60 : 1)
+
+/**
+ * @brief Slowest `C8.speed`, in percent of `tickSpeed` and the 60 Hz timer clock
+ */
+#define C8_SPEED_MIN 25
+
+/**
+ * @brief Fastest `C8.speed` other than `C8_SPEED_UNCAPPED`
+ */
+#define C8_SPEED_MAX 1600
+
+/**
+ * @brief `C8.speed` that runs as fast as the host allows
+ */
+#define C8_SPEED_UNCAPPED -1
+
+/**
+ * @brief Whether `c8` should run as fast as the host allows (uncapped, or
+ * fast-forwarding with `C8_KEY_FAST_FORWARD` held)
+ */
+#define C8_UNCAPPED(c8)                                                                            \
+    ((c8)->speed == C8_SPEED_UNCAPPED                                                              \
+     || (__atomic_load_n(&(c8)->keys, __ATOMIC_RELAXED) & C8_KEY_BIT(C8_KEY_FAST_FORWARD)))
+
+/**
+ * @brief Frames per render when uncapped, unless `C8.frameSkip` is set
+ */
+#define C8_FRAME_SKIP 8
+
 /**
  * @brief Maximum stack size
  */
 #define C8_STACK_SIZE 16
 
+/**
+ * @brief Size of the XO-CHIP audio pattern buffer in bytes (128 1-bit samples).
+ */
+#define C8_AUDIO_PATTERN_SIZE 16
+
+/**
+ * @brief Initial XO-CHIP audio pattern pitch (4000 Hz).
+ */
+#define C8_AUDIO_DEFAULT_PITCH 64
+
 /**
  * @brief CHIP-8 execution mode. SCHIP and XO-CHIP instructions will throw an error.
  */
@@ -77,40 +121,159 @@
  */
 #define C8_FLAG_QUIRK_VBLANK 0x80
 
+/**
+ * @brief Run emulation on its own thread and present frames from the calling thread.
+ */
+#define C8_FLAG_RENDER_THREAD 0x100
+
+/**
+ * @brief Budget machine cycles per frame from the cycle table of `mode` (see `c8_frame_cycles`).
+ */
+#define C8_FLAG_CYCLES 0x200
+
+/**
+ * @brief Hook called after each 60 Hz frame, once the timers were updated.
+ */
+#define C8_HOOK_FRAME 0
+
+/**
+ * @brief Hook called when an instruction changed the display (`DRW`, `CLS`,
+ * scrolling, `LOW` and `HIGH`).
+ */
+#define C8_HOOK_DRAW 1
+
+/**
+ * @brief Hook called when `LD ST, Vx` starts the tone, with the sound timer.
+ */
+#define C8_HOOK_SOUND_START 2
+
+/**
+ * @brief Hook called when the tone stops.
+ */
+#define C8_HOOK_SOUND_STOP 3
+
+/**
+ * @brief Hook called when `LD Vx, K` starts waiting for a key, with `x`.
+ */
+#define C8_HOOK_WAIT_KEY 4
+
+/**
+ * @brief Hook called when `EXIT` (`00FD`) stops the interpreter.
+ */
+#define C8_HOOK_EXIT 5
+
+/**
+ * @brief Hook called when running stops with an exception, with its code.
+ */
+#define C8_HOOK_EXCEPTION 6
+
+/**
+ * @brief Number of `C8_HOOK_*` events.
+ */
+#define C8_HOOK_COUNT 7
+
+/**
+ * @brief Call the hook of `c8` for `event` with `arg`, if one is set
+ */
+#define C8_HOOK(c8, event, arg)                                                                    \
+    do {                                                                                           \
+        if ((c8)->hooks.fn[event]) {                                                               \
+            (c8)->hooks.fn[event]((c8)->hooks.data[event], event, arg);                            \
+        }                                                                                          \
+    } while (0)
+
+/**
+ * @brief Callback for a `C8_HOOK_*` event
+ *
+ * Called on the emulation thread, with the `data` it was set with, the event
+ * and its argument (0 if the event has none).
+ */
+typedef void (*C8_Hook)(void*, int, int);
+
+/**
+  * @struct C8_Hooks
+  * @brief Callbacks set with `c8_set_hook`, indexed by `C8_HOOK_*`
+  */
+typedef struct {
+    C8_Hook fn[C8_HOOK_COUNT]; //!< Callback of each event, or NULL
+    void*   data[C8_HOOK_COUNT]; //!< User context passed to each callback
+} C8_Hooks;
+
 /**
   * @struct C8
   * @brief Represents current state of the CHIP-8 interpreter
   */
 typedef struct {
-    uint8_t    mem[C8_MEMSIZE]; //!< CHIP-8 memory
-    uint8_t    R[8]; //!< Flag registers
-    uint8_t    V[16]; //!< General purpose registers
-    uint8_t    sp; //!< Stack pointer
-    uint8_t    dt; //!< Delay timer
-    uint8_t    st; //!< Sound timer
-    uint16_t   stack[C8_STACK_SIZE]; //!< Stack
-    uint16_t   pc; //!< Program counter
-    uint16_t   I; //!< Address register
-    int        key[18]; //!< Key press states
-    int        VK; //!< Register to store next keypress
-    int        tickSpeed; //!< Instructions to execute per second
-    int        waitingForKey; //!< Waiting for keypress?
-    int        waitingForDraw; //!< Waiting for draw? (For `r` quirk)
-    int        running; //!< Interpreter running state
-    C8_Display display; //!< Graphics display
-    int        flags; //!< CLI flags
-    int        breakpoints[C8_MEMSIZE]; //!< Debug breakpoint map
-    int        colors[2]; //!< 24 bit hex colors, background=[0] foreground=[1]
-    int        fonts[2]; //!< Font IDs (see font.c)
-    int        mode; //!< Interpreter mode (C8_MODE_CHIP8, C8_MODE_SCHIP, C8_MODE_XOCHIP)
+    uint8_t       mem[C8_MEMSIZE]; //!< CHIP-8 memory
+    uint8_t       R[8]; //!< Flag registers
+    uint8_t       V[16]; //!< General purpose registers
+    uint8_t       sp; //!< Stack pointer
+    uint8_t       dt; //!< Delay timer
+    uint8_t       st; //!< Sound timer
+    uint16_t      stack[C8_STACK_SIZE]; //!< Stack
+    uint16_t      pc; //!< Program counter
+    uint16_t      I; //!< Address register
+    uint8_t       pattern[C8_AUDIO_PATTERN_SIZE]; //!< XO-CHIP audio pattern buffer
+    uint8_t       pitch; //!< XO-CHIP audio pattern pitch
+    uint8_t       patternSet; //!< 1 once `pattern` was loaded, else the buzzer plays
+    uint32_t      keys; //!< Held keys, `C8_KEY_BIT(key)` set while `key` is down
+    int           VK; //!< Register to store next keypress
+    int           tickSpeed; //!< Instructions to execute per second
+    int           pollRate; //!< Input polls per second, or 0 to poll once per frame
+    int           speed; //!< Percent of normal speed, `C8_SPEED_UNCAPPED`, or 0 for 100
+    int           frameSkip; //!< Frames per render when uncapped, or 0 for `C8_FRAME_SKIP`
+    int           waitingForKey; //!< Waiting for keypress?
+    int           waitingForDraw; //!< Waiting for draw? (For `r` quirk)
+    int           running; //!< Interpreter running state
+    C8_Display    display; //!< Graphics display
+    int           flags; //!< CLI flags
+    int           breakpoints[C8_MEMSIZE]; //!< Debug breakpoint map
+    int           colors[2]; //!< 24 bit hex colors, background=[0] foreground=[1]
+    int           fonts[2]; //!< Font IDs (see font.c)
+    int           mode; //!< Interpreter mode (C8_MODE_CHIP8, C8_MODE_SCHIP, C8_MODE_XOCHIP)
+    int           frameStep; //!< Instructions, or cycles, run so far in the current `c8_run_frame`
+    int           cycles; //!< Cycles the last instruction cost (see `C8_FLAG_CYCLES`)
+    double        frameTime; //!< Input event time at which the current `c8_run_frame` starts
+    C8_InputQueue input; //!< Key events waiting for the machine to reach their time
+    C8_Backend*   backend; //!< Graphics backend owned by this `C8` (NULL for the null backend)
+    C8_Hooks      hooks; //!< Event callbacks (see `c8_set_hook`)
 } C8;
 
+/**
+  * @struct C8_Config
+  * @brief Pristine post-load image of a `C8`, used by `c8_reset`
+  *
+  * Only the first `memUsed` bytes of `mem` (fonts and ROM) are meaningful,
+  * everything after that is zero in a freshly loaded `C8`.
+  */
+typedef struct {
+    uint8_t  mem[C8_MEMSIZE]; //!< Memory image (fonts and ROM)
+    uint16_t memUsed; //!< Bytes of `mem` in use, starting at address 0
+    int      flags; //!< Flags
+    int      tickSpeed; //!< Instructions to execute per second
+    int      pollRate; //!< Input polls per second, or 0 to poll once per frame
+    int      speed; //!< Percent of normal speed, `C8_SPEED_UNCAPPED`, or 0 for 100
+    int      frameSkip; //!< Frames per render when uncapped, or 0 for `C8_FRAME_SKIP`
+    int      colors[2]; //!< 24 bit hex colors, background=[0] foreground=[1]
+    int      fonts[2]; //!< Font IDs (see font.c)
+    int      mode; //!< Interpreter mode
+    uint8_t  displayMode; //!< Initial display mode
+} C8_Config;
+
+void        c8_copy(C8*, const C8*);
 void        c8_deinit(C8*);
+int         c8_deinit_graphics(C8*);
+int         c8_frame_cycles(const C8*);
+void        c8_get_config(const C8*, C8_Config*);
 C8*         c8_init(const char*, int);
+int         c8_init_graphics(C8*, const char*, int);
 int         c8_load_palette_s(C8*, char*);
 int         c8_load_palette_f(C8*, const char*);
 int         c8_load_quirks(C8*, const char*);
 int         c8_load_rom(C8*, const char*);
+int         c8_reset(C8*, const C8_Config*);
+int         c8_run_frame(C8*);
+int         c8_set_hook(C8*, int, C8_Hook, void*);
 int         c8_simulate(C8*);
 int         c8_validate(const C8*);
 const char* c8_version(void);
@@ -0,0 +1,306 @@
+/**
+ * @file c8/env.c
+ *
+ * Headless, batched step/observe API for running many instances at once.
+ *
+ * Each step applies one key action per instance, runs one frame with
+ * `c8_run_frame` and writes an observation into a caller-provided buffer.
+ * Instances are split into contiguous chunks and stepped on worker threads
+ * that live from `c8_env_bind` to `c8_env_unbind`.
+ */
+
+#include "env.h"
+
+#include "common.h"
+
+#include "private/exception.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+C8_STATIC int   c8_env_step(C8_Env*, int);
+C8_STATIC void  c8_env_step_chunk(C8_EnvBatch*, C8_EnvChunk*);
+C8_STATIC void* c8_env_worker(void*);
+
+/**
+ * @brief Step every bound environment by one frame and write its observation
+ *
+ * `actions[i]` is the key (0x0-0xF) held by environment `i` during this
+ * frame, or `C8_ENV_NO_ACTION`. Releasing a key (changing the action) while
+ * the instance waits on `LD Vx, K` delivers that key. `actions` may be NULL,
+ * meaning no key is held anywhere.
+ *
+ * Stopped instances are not run but still produce an observation with
+ * `done` set.
+ *
+ * @param batch environments bound by `c8_env_bind`
+ * @param actions one action per environment
+ *
+ * @return 0 if success, or the exception code of the last instance that failed.
+ */
+int c8_env_batch_step(C8_EnvBatch* batch, const int* actions) {
+    int ret    = 0;
+    int failed = 0;
+
+    if (!batch || !batch->envs) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Environments are not bound");
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    batch->actions = actions;
+    for (int t = 0; t < batch->threads; t++) {
+        batch->chunks[t].ret = 0;
+    }
+
+    pthread_mutex_lock(&batch->lock);
+    batch->generation++;
+    batch->next    = 1;
+    batch->pending = batch->threads - 1;
+    pthread_cond_broadcast(&batch->start);
+    pthread_mutex_unlock(&batch->lock);
+
+    c8_env_step_chunk(batch, &batch->chunks[0]);
+
+    pthread_mutex_lock(&batch->lock);
+    while (batch->pending > 0) {
+        pthread_cond_wait(&batch->done, &batch->lock);
+    }
+    pthread_mutex_unlock(&batch->lock);
+
+    for (int t = 0; t < batch->threads; t++) {
+        if (batch->chunks[t].ret < 0) {
+            ret    = batch->chunks[t].ret;
+            failed = batch->chunks[t].failed;
+        }
+    }
+    if (ret < 0) {
+        C8_EXCEPTION(ret, "Environment %d failed", failed);
+    }
+    return ret;
+}
+
+/**
+ * @brief Attach `n` instances to `envs` and start the threads that step them
+ *
+ * Observation `i` is written at `buffer + i * c8_env_observation_size(flags)`.
+ * Every instance is marked as running. Call `c8_env_unbind` when done.
+ *
+ * @param batch batch to initialize
+ * @param envs environments to initialize
+ * @param c8s array of `n` loaded instances
+ * @param n number of environments
+ * @param buffer contiguous observation buffer
+ * @param rewardAddr memory address of the reward byte, or -1 for none
+ * @param flags `C8_ENV_FLAG_*`
+ *
+ * @return 0 if success, exception code on failure.
+ */
+int c8_env_bind(C8_EnvBatch* batch, C8_Env* envs, C8* c8s, int n, void* buffer, int rewardAddr,
+                int flags) {
+    size_t stride  = c8_env_observation_size(flags);
+    long   cpus    = sysconf(_SC_NPROCESSORS_ONLN);
+    int    threads = n / C8_ENV_MIN_PER_THREAD;
+    int    per, rem, off = 0;
+
+    if (!batch || n <= 0 || !buffer || rewardAddr >= C8_MEMSIZE) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid environment parameters");
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    if (threads > cpus) {
+        threads = (int) cpus;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    memset(batch, 0, sizeof(C8_EnvBatch));
+    batch->chunks  = malloc(threads * sizeof(C8_EnvChunk));
+    batch->workers = malloc(threads * sizeof(pthread_t));
+    if (!batch->chunks || !batch->workers) {
+        free(batch->chunks);
+        free(batch->workers);
+        batch->chunks  = NULL;
+        batch->workers = NULL;
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION, "Failed to allocate environment threads");
+        return C8_INVALID_STATE_EXCEPTION;
+    }
+
+    for (int i = 0; i < n; i++) {
+        envs[i].c8         = &c8s[i];
+        envs[i].obs        = (C8_Observation*) ((char*) buffer + i * stride);
+        envs[i].rewardAddr = rewardAddr;
+        envs[i].flags      = flags;
+        envs[i].action     = C8_ENV_NO_ACTION;
+        c8s[i].running     = 1;
+    }
+
+    batch->envs  = envs;
+    batch->count = n;
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->start, NULL);
+    pthread_cond_init(&batch->done, NULL);
+
+    /* Fewer threads than planned is fine: the chunks are laid out afterwards */
+    batch->threads = 1;
+    while (batch->threads < threads) {
+        if (pthread_create(&batch->workers[batch->threads - 1], NULL, c8_env_worker, batch) != 0) {
+            break;
+        }
+        batch->threads++;
+    }
+
+    per = n / batch->threads;
+    rem = n % batch->threads;
+    for (int t = 0; t < batch->threads; t++) {
+        batch->chunks[t].first  = off;
+        batch->chunks[t].count  = per + (t < rem);
+        batch->chunks[t].ret    = 0;
+        batch->chunks[t].failed = 0;
+        off += batch->chunks[t].count;
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the size of one observation
+ *
+ * @param flags `C8_ENV_FLAG_*`
+ *
+ * @return distance in bytes between consecutive observations
+ */
+size_t c8_env_observation_size(int flags) {
+    size_t size = sizeof(C8_Observation);
+    if (flags & C8_ENV_FLAG_OBSERVE_RAM) {
+        size += C8_MEMSIZE;
+    }
+    return size;
+}
+
+/**
+ * @brief Stop and join the threads started by `c8_env_bind`
+ *
+ * The environments and instances are left as they are. Does nothing if
+ * `batch` is not bound.
+ *
+ * @param batch batch to release
+ */
+void c8_env_unbind(C8_EnvBatch* batch) {
+    if (!batch || !batch->envs) {
+        return;
+    }
+
+    pthread_mutex_lock(&batch->lock);
+    batch->stopping = 1;
+    pthread_cond_broadcast(&batch->start);
+    pthread_mutex_unlock(&batch->lock);
+    for (int t = 0; t < batch->threads - 1; t++) {
+        pthread_join(batch->workers[t], NULL);
+    }
+
+    pthread_cond_destroy(&batch->done);
+    pthread_cond_destroy(&batch->start);
+    pthread_mutex_destroy(&batch->lock);
+    free(batch->chunks);
+    free(batch->workers);
+    memset(batch, 0, sizeof(C8_EnvBatch));
+}
+
+/**
+ * @brief Apply `action`, run one frame and write the observation of `env`
+ *
+ * @param env environment to step
+ * @param action key held during this frame, or `C8_ENV_NO_ACTION`
+ *
+ * @return 0 if success, exception code on failure
+ */
+C8_STATIC int c8_env_step(C8_Env* env, int action) {
+    C8*             c8  = env->c8;
+    C8_Observation* obs = env->obs;
+    int             ret = 0;
+
+    if (env->action >= 0) {
+        c8_input_set_key(&c8->keys, env->action, 0);
+        if (env->action != action && c8->waitingForKey) {
+            c8->V[c8->VK]     = env->action;
+            c8->waitingForKey = 0;
+        }
+    }
+    env->action = (action >= 0 && action <= 0xF) ? action : C8_ENV_NO_ACTION;
+    if (env->action >= 0) {
+        c8_input_set_key(&c8->keys, env->action, 1);
+    }
+
+    if (c8->running) {
+        ret = c8_run_frame(c8);
+        if (ret < 0) {
+            c8->running = 0;
+        }
+    }
+
+    obs->reward      = env->rewardAddr >= 0 ? c8->mem[env->rewardAddr] : 0;
+    obs->done        = !c8->running;
+    obs->displayMode = c8->display.mode;
+    memset(obs->frame, 0, C8_PACKED_DISPLAY_SIZE);
+    c8_display_pack(&c8->display, obs->frame);
+    if (env->flags & C8_ENV_FLAG_OBSERVE_RAM) {
+        memcpy(obs + 1, c8->mem, C8_MEMSIZE);
+    }
+    return ret;
+}
+
+/**
+ * @brief Step every environment of `chunk`
+ *
+ * Failures are recorded in `chunk` for `c8_env_batch_step` to report.
+ *
+ * @param batch batch being stepped
+ * @param chunk chunk to step
+ */
+C8_STATIC void c8_env_step_chunk(C8_EnvBatch* batch, C8_EnvChunk* chunk) {
+    for (int i = chunk->first; i < chunk->first + chunk->count; i++) {
+        int action = batch->actions ? batch->actions[i] : C8_ENV_NO_ACTION;
+        int ret    = c8_env_step(&batch->envs[i], action);
+        if (ret < 0) {
+            chunk->ret    = ret;
+            chunk->failed = i;
+        }
+    }
+}
+
+/**
+ * @brief Step one chunk per `c8_env_batch_step` until `c8_env_unbind`
+ *
+ * @param arg `C8_EnvBatch` to step
+ *
+ * @return NULL
+ */
+C8_STATIC void* c8_env_worker(void* arg) {
+    C8_EnvBatch*  batch = (C8_EnvBatch*) arg;
+    C8_EnvChunk*  chunk;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&batch->lock);
+    for (;;) {
+        while (!batch->stopping && batch->generation == seen) {
+            pthread_cond_wait(&batch->start, &batch->lock);
+        }
+        if (batch->stopping) {
+            break;
+        }
+        seen  = batch->generation;
+        chunk = &batch->chunks[batch->next++];
+        pthread_mutex_unlock(&batch->lock);
+
+        c8_env_step_chunk(batch, chunk);
+
+        pthread_mutex_lock(&batch->lock);
+        if (--batch->pending == 0) {
+            pthread_cond_signal(&batch->done);
+        }
+    }
+    pthread_mutex_unlock(&batch->lock);
+    return NULL;
+}
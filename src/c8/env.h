@@ -0,0 +1,99 @@
+/**
+ * @file c8/env.h
+ *
+ * Headless, batched step/observe API for running many instances at once.
+ */
+
+#ifndef C8_ENV_H
+#define C8_ENV_H
+
+#include "chip8.h"
+#include "graphics.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Append the full memory of the instance to each observation
+ */
+#define C8_ENV_FLAG_OBSERVE_RAM 0x1
+
+/**
+ * @brief Action meaning "no key held"
+ */
+#define C8_ENV_NO_ACTION -1
+
+/**
+ * @brief Smallest number of environments handed to one worker thread
+ */
+#define C8_ENV_MIN_PER_THREAD 16
+
+/**
+  * @struct C8_Observation
+  * @brief Fixed header of one observation
+  *
+  * With `C8_ENV_FLAG_OBSERVE_RAM`, `C8_MEMSIZE` bytes of memory follow the
+  * header. Use `c8_env_observation_size` for the stride between observations.
+  */
+typedef struct {
+    int32_t reward; //!< `mem[rewardAddr]`, or 0 without a reward address
+    uint8_t done; //!< 1 if the instance stopped or raised an exception
+    uint8_t displayMode; //!< Resolution of `frame` (`C8_DISPLAYMODE_*`)
+    uint8_t reserved[2];
+    uint8_t frame[C8_PACKED_DISPLAY_SIZE]; //!< `c8_display_pack` of the display
+} C8_Observation;
+
+/**
+  * @struct C8_Env
+  * @brief One instance driven by `c8_env_batch_step`
+  */
+typedef struct {
+    C8*             c8; //!< Instance to run (must be loaded and not owned by a backend)
+    C8_Observation* obs; //!< Where this environment's observation is written
+    int             rewardAddr; //!< Memory address of the reward byte, or -1 for none
+    int             flags; //!< `C8_ENV_FLAG_*`
+    int             action; //!< Key held during the previous step, or `C8_ENV_NO_ACTION`
+} C8_Env;
+
+/**
+  * @struct C8_EnvChunk
+  * @brief Contiguous range of environments stepped by one thread
+  */
+typedef struct {
+    int first; //!< Index of the first environment
+    int count; //!< Number of environments
+    int ret; //!< Exception code of the last environment that failed this step, or 0
+    int failed; //!< Index of that environment
+} C8_EnvChunk;
+
+/**
+  * @struct C8_EnvBatch
+  * @brief Environments bound by `c8_env_bind` and the threads that step them
+  *
+  * The worker threads are started by `c8_env_bind`, woken once per
+  * `c8_env_batch_step` and joined by `c8_env_unbind`. The calling thread
+  * steps the first chunk itself.
+  */
+typedef struct {
+    C8_Env*         envs; //!< Environments to step
+    int             count; //!< Number of environments
+    int             threads; //!< Number of chunks (worker threads plus the caller)
+    C8_EnvChunk*    chunks; //!< One chunk per thread
+    pthread_t*      workers; //!< `threads - 1` worker threads
+    const int*      actions; //!< Actions of the step in progress
+    unsigned long   generation; //!< Number of steps started
+    int             next; //!< Next chunk to be claimed by a worker
+    int             pending; //!< Number of workers still stepping a chunk
+    int             stopping; //!< Set by `c8_env_unbind` to stop the workers
+    pthread_mutex_t lock; //!< Protects `generation`, `next`, `pending` and `stopping`
+    pthread_cond_t  start; //!< Signalled when a step starts or `stopping` is set
+    pthread_cond_t  done; //!< Signalled when `pending` reaches 0
+} C8_EnvBatch;
+
+int    c8_env_batch_step(C8_EnvBatch*, const int*);
+int    c8_env_bind(C8_EnvBatch*, C8_Env*, C8*, int, void*, int, int);
+size_t c8_env_observation_size(int);
+void   c8_env_unbind(C8_EnvBatch*);
+
+#endif
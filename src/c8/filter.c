@@ -0,0 +1,429 @@
+/**
+ * @file c8/filter.c
+ *
+ * Pixel-art upscaling filters for `C8_Display`.
+ *
+ * Since CHIP-8 pixels are either on or off, every EPX-style rule ("this
+ * neighbour equals that one and differs from the other") is a handful of
+ * bitwise operations. Each display row is loaded into 64-bit words and the
+ * rules are evaluated 64 pixels at a time; the resulting rows are then
+ * expanded to 32-bit pixels with the same SIMD code as
+ * `c8_display_to_rgba32`.
+ */
+
+#include "filter.h"
+
+#include "common.h"
+
+#include "private/exception.h"
+#include "private/util.h"
+
+#include <string.h>
+
+/**
+ * @brief Number of 64-bit words in the widest bit row (4x the display width).
+ */
+#define C8_FILTER_WORDS (C8_HIGH_DISPLAY_WIDTH * C8_FILTER_MAX_SCALE / 64)
+
+/**
+ * @brief Pick bits of `x` where `c` is set and bits of `y` elsewhere.
+ */
+#define C8_SELECT(c, x, y) (((c) & (x)) | (~(c) & (y)))
+
+C8_STATIC void c8_filter_bytes(const uint64_t*, const uint64_t*, int, uint8_t*);
+C8_STATIC void c8_filter_emit(uint8_t*, int, const uint8_t*, int, const uint32_t*);
+C8_STATIC void c8_filter_interleave(const uint64_t*, const uint64_t*, int, uint64_t*);
+C8_STATIC void c8_filter_left(const uint64_t*, int, uint64_t*);
+C8_STATIC void c8_filter_load(const C8_Display*, int, int, int, uint64_t*);
+C8_STATIC void c8_filter_right(const uint64_t*, int, uint64_t*);
+C8_STATIC void c8_filter_scale2x(const uint64_t*,
+                                 const uint64_t*,
+                                 const uint64_t*,
+                                 int,
+                                 uint64_t (*)[C8_FILTER_WORDS],
+                                 uint64_t (*)[C8_FILTER_WORDS]);
+C8_STATIC void c8_filter_scale3x(const uint64_t*,
+                                 const uint64_t*,
+                                 const uint64_t*,
+                                 int,
+                                 uint64_t (*)[C8_FILTER_WORDS]);
+C8_STATIC uint64_t c8_filter_spread(uint32_t);
+
+/**
+ * @brief Names accepted by `c8_get_filter`, indexed by filter >> 8
+ */
+C8_STATIC const char* c8_filterNames[] = { "none", "scale2x", "scale3x", "scale4x", "hq2x" };
+
+/**
+ * @brief Upscale rows `first` to `first + count - 1` of `display` into `out`
+ *
+ * `out` receives `count * scale` rows of `width * scale` pixels, where
+ * `scale` is `c8_filter_scale(filter)`, in the same format as
+ * `c8_display_to_rgba32`. Rows outside the range are read but not written,
+ * so a caller that knows which rows changed only has to redo those and the
+ * `C8_FILTER_RADIUS` rows around them.
+ *
+ * @param display `C8_Display` to upscale
+ * @param colors background and foreground colors
+ * @param filter `C8_FILTER_*`
+ * @param out where to store the pixels of row `first`
+ * @param pitch bytes from one row of `out` to the next
+ * @param first first display row to upscale
+ * @param count number of display rows to upscale
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION on invalid parameters
+ */
+int c8_display_filter(const C8_Display* display,
+                      const int*        colors,
+                      int               filter,
+                      uint32_t*         out,
+                      int               pitch,
+                      int               first,
+                      int               count) {
+    int width
+        = (display->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_WIDTH : C8_HIGH_DISPLAY_WIDTH;
+    int height
+        = (display->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_HEIGHT : C8_HIGH_DISPLAY_HEIGHT;
+    int      scale = c8_filter_scale(filter);
+    uint32_t lut[3];
+    uint64_t src[5][C8_FILTER_WORDS];
+    uint64_t mid[4][C8_FILTER_WORDS];
+    uint64_t rows[9][C8_FILTER_WORDS];
+    uint64_t blend[2][C8_FILTER_WORDS];
+    uint8_t  bytes[C8_HIGH_DISPLAY_WIDTH * C8_FILTER_MAX_SCALE];
+
+    if (scale < 1 || pitch < width * scale * (int) sizeof(uint32_t) || first < 0 || count < 0
+        || first + count > height) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION,
+                     "Invalid filter %d or rows %d-%d",
+                     filter,
+                     first,
+                     first + count - 1);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    lut[0] = 0xFF000000 | ((uint32_t) colors[0] & 0xFFFFFF);
+    lut[1] = 0xFF000000 | ((uint32_t) colors[1] & 0xFFFFFF);
+    lut[2] = 0xFF000000 | (((lut[0] & 0xFEFEFE) >> 1) + ((lut[1] & 0xFEFEFE) >> 1));
+
+    for (int y = first; y < first + count; y++) {
+        uint8_t* dst = (uint8_t*) out + (size_t) (y - first) * scale * pitch;
+
+        switch (filter) {
+        case C8_FILTER_NONE:
+            c8_expand_row(
+                &display->p[y * width], width, lut[0], lut[0] ^ lut[1], (uint32_t*) dst, 1);
+            break;
+        case C8_FILTER_SCALE2X:
+        case C8_FILTER_HQ2X:
+            for (int i = 0; i < 3; i++) {
+                c8_filter_load(display, width, height, y - 1 + i, src[i]);
+            }
+            c8_filter_scale2x(
+                src[0], src[1], src[2], width, rows, filter == C8_FILTER_HQ2X ? blend : NULL);
+            for (int i = 0; i < 2; i++) {
+                const uint64_t* m = (filter == C8_FILTER_HQ2X) ? blend[i] : NULL;
+                c8_filter_bytes(rows[i], m, width * 2, bytes);
+                c8_filter_emit(dst + i * pitch, width * 2, bytes, m != NULL, lut);
+            }
+            break;
+        case C8_FILTER_SCALE3X:
+            for (int i = 0; i < 3; i++) {
+                c8_filter_load(display, width, height, y - 1 + i, src[i]);
+            }
+            c8_filter_scale3x(src[0], src[1], src[2], width, rows);
+            for (int i = 0; i < 3; i++) {
+                uint8_t* b = bytes;
+                for (int x = 0; x < width; x++) {
+                    for (int k = 0; k < 3; k++) {
+                        *b++ = (rows[i * 3 + k][x >> 6] >> (x & 63)) & 1;
+                    }
+                }
+                c8_filter_emit(dst + i * pitch, width * 3, bytes, 0, lut);
+            }
+            break;
+        case C8_FILTER_SCALE4X:
+            /* Rows 2y - 1 to 2y + 2 of the Scale2x image, then Scale2x again */
+            for (int i = 0; i < 5; i++) {
+                c8_filter_load(display, width, height, y - 2 + i, src[i]);
+            }
+            for (int i = 0; i < 3; i++) {
+                c8_filter_scale2x(src[i], src[i + 1], src[i + 2], width, &rows[i * 2], NULL);
+            }
+            memcpy(mid[0], y > 0 ? rows[1] : rows[2], sizeof(mid[0]));
+            memcpy(mid[1], rows[2], sizeof(mid[1]));
+            memcpy(mid[2], rows[3], sizeof(mid[2]));
+            memcpy(mid[3], y < height - 1 ? rows[4] : rows[3], sizeof(mid[3]));
+
+            for (int i = 0; i < 2; i++) {
+                c8_filter_scale2x(mid[i], mid[i + 1], mid[i + 2], width * 2, rows, NULL);
+                for (int j = 0; j < 2; j++) {
+                    c8_filter_bytes(rows[j], NULL, width * 4, bytes);
+                    c8_filter_emit(dst + (i * 2 + j) * pitch, width * 4, bytes, 0, lut);
+                }
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the scale factor of `filter`
+ *
+ * @param filter `C8_FILTER_*`
+ *
+ * @return the scale factor, or 0 if `filter` is unknown
+ */
+int c8_filter_scale(int filter) {
+    switch (filter) {
+    case C8_FILTER_NONE:
+        return 1;
+    case C8_FILTER_SCALE2X:
+    case C8_FILTER_HQ2X:
+        return 2;
+    case C8_FILTER_SCALE3X:
+        return 3;
+    case C8_FILTER_SCALE4X:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Look up a filter by name
+ *
+ * @param name "none", "scale2x", "scale3x", "scale4x" or "hq2x"
+ *
+ * @return `C8_FILTER_*`, or C8_INVALID_PARAMETER_EXCEPTION if `name` is unknown
+ */
+int c8_get_filter(const char* name) {
+    for (int i = 0; i < (int) (sizeof(c8_filterNames) / sizeof(c8_filterNames[0])); i++) {
+        if (strcmp(name, c8_filterNames[i]) == 0) {
+            return i << 8;
+        }
+    }
+
+    C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Unknown filter: %s", name);
+    return C8_INVALID_PARAMETER_EXCEPTION;
+}
+
+/**
+ * @brief Unpack `w` bits to one byte each, 2 where `blend` is set
+ *
+ * @param bits bit row
+ * @param blend bits to blend, or NULL
+ * @param w number of bits
+ * @param out where to store `w` bytes
+ */
+C8_STATIC void c8_filter_bytes(const uint64_t* bits, const uint64_t* blend, int w, uint8_t* out) {
+    for (int x = 0; x < w; x++) {
+        out[x] = (bits[x >> 6] >> (x & 63)) & 1;
+        if (blend && ((blend[x >> 6] >> (x & 63)) & 1)) {
+            out[x] = 2;
+        }
+    }
+}
+
+/**
+ * @brief Convert `n` bytes from `c8_filter_bytes` to pixels
+ *
+ * @param dst where to store the pixels
+ * @param n number of pixels
+ * @param bytes values (0, 1, or 2 if `blended`)
+ * @param blended 1 if `bytes` may contain 2
+ * @param lut background, foreground and blended pixels
+ */
+C8_STATIC void
+c8_filter_emit(uint8_t* dst, int n, const uint8_t* bytes, int blended, const uint32_t* lut) {
+    uint32_t* out = (uint32_t*) dst;
+    if (!blended) {
+        c8_expand_row(bytes, n, lut[0], lut[0] ^ lut[1], out, 1);
+        return;
+    }
+
+    for (int x = 0; x < n; x++) {
+        out[x] = lut[bytes[x]];
+    }
+}
+
+/**
+ * @brief Interleave two bit rows, `l` on even and `r` on odd bits
+ *
+ * @param l left bits
+ * @param r right bits
+ * @param w number of bits in `l` and `r`
+ * @param out where to store `2 * w` bits
+ */
+C8_STATIC void c8_filter_interleave(const uint64_t* l, const uint64_t* r, int w, uint64_t* out) {
+    for (int i = 0; i < w / 64; i++) {
+        out[i * 2]     = c8_filter_spread(l[i]) | c8_filter_spread(r[i]) << 1;
+        out[i * 2 + 1] = c8_filter_spread(l[i] >> 32) | c8_filter_spread(r[i] >> 32) << 1;
+    }
+}
+
+/**
+ * @brief Shift a bit row so that bit x holds bit x - 1, repeating the first bit
+ *
+ * @param p bit row
+ * @param w number of bits
+ * @param out where to store the left neighbours
+ */
+C8_STATIC void c8_filter_left(const uint64_t* p, int w, uint64_t* out) {
+    uint64_t carry = p[0] & 1;
+    for (int i = 0; i < w / 64; i++) {
+        out[i] = (p[i] << 1) | carry;
+        carry  = p[i] >> 63;
+    }
+}
+
+/**
+ * @brief Load row `y` of `display` into bits, repeating the edge rows
+ *
+ * @param display `C8_Display` to read
+ * @param width display width
+ * @param height display height
+ * @param y row to load, clamped to the display
+ * @param out where to store `width` bits
+ */
+C8_STATIC void
+c8_filter_load(const C8_Display* display, int width, int height, int y, uint64_t* out) {
+    const uint8_t* p;
+
+    y = y < 0 ? 0 : (y >= height ? height - 1 : y);
+    p = &display->p[y * width];
+    for (int i = 0; i < width / 64; i++) {
+        uint64_t word = 0;
+        for (int x = 63; x >= 0; x--) {
+            word = (word << 1) | (p[i * 64 + x] & 1);
+        }
+        out[i] = word;
+    }
+}
+
+/**
+ * @brief Shift a bit row so that bit x holds bit x + 1, repeating the last bit
+ *
+ * @param p bit row
+ * @param w number of bits, a multiple of 64
+ * @param out where to store the right neighbours
+ */
+C8_STATIC void c8_filter_right(const uint64_t* p, int w, uint64_t* out) {
+    int n = w / 64;
+    for (int i = 0; i < n; i++) {
+        uint64_t next = (i + 1 < n) ? p[i + 1] : (p[i] >> 63);
+        out[i]        = (p[i] >> 1) | (next << 63);
+    }
+}
+
+/**
+ * @brief Scale2x one bit row
+ *
+ * @param a row above
+ * @param p row to scale
+ * @param d row below
+ * @param w number of bits in each row
+ * @param out where to store the top and bottom output rows (`2 * w` bits each)
+ * @param blend where to store which output bits Scale2x changed, or NULL
+ */
+C8_STATIC void c8_filter_scale2x(const uint64_t* a,
+                                 const uint64_t* p,
+                                 const uint64_t* d,
+                                 int             w,
+                                 uint64_t (*out)[C8_FILTER_WORDS],
+                                 uint64_t (*blend)[C8_FILTER_WORDS]) {
+    uint64_t c[C8_FILTER_WORDS / 2];
+    uint64_t b[C8_FILTER_WORDS / 2];
+    uint64_t e[4][C8_FILTER_WORDS / 2];
+    uint64_t m[4][C8_FILTER_WORDS / 2];
+
+    c8_filter_left(p, w, c);
+    c8_filter_right(p, w, b);
+
+    for (int i = 0; i < w / 64; i++) {
+        uint64_t c1 = ~(c[i] ^ a[i]) & (c[i] ^ d[i]) & (a[i] ^ b[i]);
+        uint64_t c2 = ~(a[i] ^ b[i]) & (a[i] ^ c[i]) & (b[i] ^ d[i]);
+        uint64_t c3 = ~(d[i] ^ c[i]) & (d[i] ^ b[i]) & (c[i] ^ a[i]);
+        uint64_t c4 = ~(b[i] ^ d[i]) & (b[i] ^ a[i]) & (d[i] ^ c[i]);
+
+        e[0][i] = C8_SELECT(c1, a[i], p[i]);
+        e[1][i] = C8_SELECT(c2, b[i], p[i]);
+        e[2][i] = C8_SELECT(c3, c[i], p[i]);
+        e[3][i] = C8_SELECT(c4, d[i], p[i]);
+        m[0][i] = e[0][i] ^ p[i];
+        m[1][i] = e[1][i] ^ p[i];
+        m[2][i] = e[2][i] ^ p[i];
+        m[3][i] = e[3][i] ^ p[i];
+    }
+
+    c8_filter_interleave(e[0], e[1], w, out[0]);
+    c8_filter_interleave(e[2], e[3], w, out[1]);
+    if (blend) {
+        c8_filter_interleave(m[0], m[1], w, blend[0]);
+        c8_filter_interleave(m[2], m[3], w, blend[1]);
+    }
+}
+
+/**
+ * @brief Scale3x one bit row
+ *
+ * @param up row above
+ * @param p row to scale
+ * @param down row below
+ * @param w number of bits in each row
+ * @param out where to store the 9 output bit rows, `E0` to `E8` of each
+ * 3x3 block in reading order
+ */
+C8_STATIC void c8_filter_scale3x(const uint64_t* up,
+                                 const uint64_t* p,
+                                 const uint64_t* down,
+                                 int             w,
+                                 uint64_t (*out)[C8_FILTER_WORDS]) {
+    uint64_t l[3][C8_FILTER_WORDS];
+    uint64_t r[3][C8_FILTER_WORDS];
+    const uint64_t* rows[3] = { up, p, down };
+
+    for (int i = 0; i < 3; i++) {
+        c8_filter_left(rows[i], w, l[i]);
+        c8_filter_right(rows[i], w, r[i]);
+    }
+
+    for (int i = 0; i < w / 64; i++) {
+        uint64_t A = l[0][i], B = up[i], C = r[0][i];
+        uint64_t D = l[1][i], E = p[i], F = r[1][i];
+        uint64_t G = l[2][i], H = down[i], I = r[2][i];
+
+        uint64_t bd = ~(D ^ B) & (B ^ F) & (D ^ H);
+        uint64_t bf = ~(B ^ F) & (B ^ D) & (F ^ H);
+        uint64_t dh = ~(D ^ H) & (D ^ B) & (H ^ F);
+        uint64_t hf = ~(H ^ F) & (D ^ H) & (B ^ F);
+
+        out[0][i] = C8_SELECT(bd, D, E);
+        out[1][i] = C8_SELECT((bd & (E ^ C)) | (bf & (E ^ A)), B, E);
+        out[2][i] = C8_SELECT(bf, F, E);
+        out[3][i] = C8_SELECT((bd & (E ^ G)) | (dh & (E ^ A)), D, E);
+        out[4][i] = E;
+        out[5][i] = C8_SELECT((bf & (E ^ I)) | (hf & (E ^ C)), F, E);
+        out[6][i] = C8_SELECT(dh, D, E);
+        out[7][i] = C8_SELECT((dh & (E ^ I)) | (hf & (E ^ G)), H, E);
+        out[8][i] = C8_SELECT(hf, F, E);
+    }
+}
+
+/**
+ * @brief Spread the 32 bits of `v` to the even bits of a 64-bit word
+ *
+ * @param v bits to spread
+ *
+ * @return the spread bits
+ */
+C8_STATIC uint64_t c8_filter_spread(uint32_t v) {
+    uint64_t x = v;
+    x          = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x          = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x          = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x          = (x | (x << 2)) & 0x3333333333333333ULL;
+    x          = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
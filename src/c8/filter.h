@@ -0,0 +1,60 @@
+/**
+ * @file c8/filter.h
+ *
+ * Pixel-art upscaling filters for `C8_Display`.
+ */
+
+#ifndef C8_FILTER_H
+#define C8_FILTER_H
+
+#include "graphics.h"
+
+#include <stdint.h>
+
+/**
+ * @brief No filter, one output pixel per display pixel.
+ */
+#define C8_FILTER_NONE 0x000
+
+/**
+ * @brief Scale2x (EPX), 2x.
+ */
+#define C8_FILTER_SCALE2X 0x100
+
+/**
+ * @brief Scale3x, 3x.
+ */
+#define C8_FILTER_SCALE3X 0x200
+
+/**
+ * @brief Scale2x applied twice, 4x.
+ */
+#define C8_FILTER_SCALE4X 0x300
+
+/**
+ * @brief Scale2x with the corners it fills blended half-way, 2x.
+ *
+ * This smooths diagonals the way hq2x does, without hq2x's lookup table.
+ */
+#define C8_FILTER_HQ2X 0x400
+
+/**
+ * @brief Bits of the graphics flags holding a `C8_FILTER_*` value.
+ */
+#define C8_FILTER_MASK 0xF00
+
+/**
+ * @brief Largest scale factor of any filter.
+ */
+#define C8_FILTER_MAX_SCALE 4
+
+/**
+ * @brief Number of display rows above and below a row that affect its output.
+ */
+#define C8_FILTER_RADIUS 2
+
+int c8_display_filter(const C8_Display*, const int*, int, uint32_t*, int, int, int);
+int c8_filter_scale(int);
+int c8_get_filter(const char*);
+
+#endif
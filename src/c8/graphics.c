@@ -1,97 +1,423 @@
 /**
  * @file c8/graphics.c
  *
- * Backend-agnostic graphics-related functions
+ * Backend registry and backend-agnostic graphics-related functions
  */
 
 #include "graphics.h"
+
+#include "chip8.h"
+
+#include "private/backend.h"
 #include "private/exception.h"
+#include "private/util.h"
 
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+C8_STATIC int  c8_add_backend(const C8_Backend*);
+C8_STATIC int  c8_null_init(C8_Backend*);
+C8_STATIC int  c8_null_render(C8_Backend*, C8_Display*, int*);
+C8_STATIC int  c8_null_sound_pattern(C8_Backend*, const uint8_t*, int);
+C8_STATIC int  c8_null_tick(C8_Backend*, uint32_t*);
+C8_STATIC void c8_register_builtin_backends(void);
+C8_STATIC int  c8_wrapper_deinit(C8_Backend*);
+C8_STATIC int  c8_wrapper_render(C8_Backend*, C8_Display*, int*);
+C8_STATIC int  c8_wrapper_sound_pattern(C8_Backend*, const uint8_t*, int);
+C8_STATIC int  c8_wrapper_sound_play(C8_Backend*);
+C8_STATIC int  c8_wrapper_sound_stop(C8_Backend*);
+C8_STATIC int  c8_wrapper_tick(C8_Backend*, uint32_t*);
+
+/**
+ * @brief Backend that draws nothing, reads no input and plays no sound
+ *
+ * Used by every `C8` without a backend of its own.
+ */
+C8_Backend c8_nullBackend = {
+    .name          = "null",
+    .init          = c8_null_init,
+    .deinit        = c8_null_init,
+    .render        = c8_null_render,
+    .tick          = c8_null_tick,
+    .sound_play    = c8_null_init,
+    .sound_stop    = c8_null_init,
+    .sound_pattern = c8_null_sound_pattern,
+};
+
+C8_STATIC C8_Backend      c8_backends[C8_MAX_BACKENDS];
+C8_STATIC int             c8_backendCount = 0;
+C8_STATIC pthread_once_t  c8_backendsOnce = PTHREAD_ONCE_INIT;
+C8_STATIC pthread_mutex_t c8_backendsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Deinitialize the backend of `c8`
+ *
+ * `c8` is left with the null backend.
+ *
+ * @param c8 `C8` to deinitialize the backend of
+ *
+ * @return 0 if success, exception code on failure
+ */
+int c8_deinit_graphics(C8* c8) {
+    int ret = 0;
+    if (c8->backend) {
+        ret = c8->backend->deinit(c8->backend);
+        free(c8->backend);
+        c8->backend = NULL;
+    }
+    return ret;
+}
+
+/**
+ * @brief Look up a registered backend
+ *
+ * @param name backend name, or NULL for the default backend (the first of
+ * `sdl2`, `ncurses` and `offscreen` that was compiled in)
+ *
+ * @return the backend template, or NULL if `name` is not registered.
+ */
+const C8_Backend* c8_get_backend(const char* name) {
+    const C8_Backend* backend = NULL;
+
+    pthread_once(&c8_backendsOnce, c8_register_builtin_backends);
+    pthread_mutex_lock(&c8_backendsLock);
+    if (!name) {
+        backend = &c8_backends[0];
+    }
+    for (int i = 0; !backend && i < c8_backendCount; i++) {
+        if (strcmp(c8_backends[i].name, name) == 0) {
+            backend = &c8_backends[i];
+        }
+    }
+    pthread_mutex_unlock(&c8_backendsLock);
+    return backend;
+}
+
+/**
+ * @brief Give `c8` its own instance of the backend called `name` and initialize it
+ *
+ * Any backend `c8` already had is deinitialized first.
+ *
+ * @param c8 `C8` to initialize graphics for
+ * @param name backend name, or NULL for the default backend
+ * @param flags `C8_GRAPHICS_FLAG_*`
+ *
+ * @return 0 if success, exception code on failure
+ */
+int c8_init_graphics(C8* c8, const char* name, int flags) {
+    const C8_Backend* tmpl = c8_get_backend(name);
+    C8_Backend*       backend;
+    int               ret;
+
+    if (!tmpl) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Unknown backend: %s", name);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    if (!(backend = malloc(sizeof(C8_Backend)))) {
+        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Failed to allocate backend %s", tmpl->name);
+        return C8_GRAPHICS_EXCEPTION;
+    }
+    pthread_mutex_lock(&c8_backendsLock);
+    memcpy(backend, tmpl, sizeof(C8_Backend));
+    pthread_mutex_unlock(&c8_backendsLock);
+    backend->input = &c8->input;
+    backend->flags = flags;
+
+    if ((ret = backend->init(backend)) < 0) {
+        free(backend);
+        return ret;
+    }
+
+    c8_deinit_graphics(c8);
+    c8->backend = backend;
+    return 0;
+}
 
 /**
- * @brief Stop sound
+ * @brief Register a backend, replacing any backend with the same name
  *
- * This function is weak and is overridden by internal/graphics_sdl.c by
- * default. This can also be overridden by the user when compiling without
- * SDL2 support.
+ * `backend` is copied. Function pointers left NULL are replaced by ones
+ * that do nothing.
  *
- * This function should return 0 on success and a negative value on failure.
+ * @param backend the backend template
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION on failure
  */
-__attribute__((weak)) int c8_sound_play(void) {
-    C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "%s not implemented.", __func__);
-    return C8_GRAPHICS_EXCEPTION;
+int c8_register_backend(const C8_Backend* backend) {
+    int ret;
+
+    pthread_once(&c8_backendsOnce, c8_register_builtin_backends);
+    pthread_mutex_lock(&c8_backendsLock);
+    ret = c8_add_backend(backend);
+    pthread_mutex_unlock(&c8_backendsLock);
+    return ret;
 }
 
 /**
- * @brief Play sound
+ * @brief Wrap the backend of `c8` in a copy of `wrapper`
+ *
+ * The functions of `wrapper` left NULL pass through to the wrapped backend,
+ * which is deinitialized along with the wrapper. `init` and `deinit` are
+ * always replaced. `ctx` of the new backend is a `C8_BackendWrapper` holding
+ * `data`.
  *
- * This function is weak and is overridden by internal/graphics_sdl.c by
- * default. This can also be overridden by the user when compiling without
- * SDL2 support.
+ * @param c8 `C8` whose backend to wrap
+ * @param wrapper the wrapper template
+ * @param data wrapper state
  *
- * This function should return 0 on success and a negative value on failure.
+ * @return 0 if success, C8_GRAPHICS_EXCEPTION on failure
  */
-__attribute__((weak)) int c8_sound_stop(void) {
-    C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "%s not implemented.", __func__);
-    return C8_GRAPHICS_EXCEPTION;
+int c8_wrap_backend(C8* c8, const C8_Backend* wrapper, void* data) {
+    C8_Backend*        backend = malloc(sizeof(C8_Backend));
+    C8_BackendWrapper* ctx     = malloc(sizeof(C8_BackendWrapper));
+
+    if (!backend || !ctx) {
+        free(backend);
+        free(ctx);
+        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Failed to allocate backend %s", wrapper->name);
+        return C8_GRAPHICS_EXCEPTION;
+    }
+
+    ctx->inner = c8->backend;
+    ctx->data  = data;
+
+    memcpy(backend, wrapper, sizeof(C8_Backend));
+    backend->init       = c8_null_init;
+    backend->deinit     = c8_wrapper_deinit;
+    backend->render     = wrapper->render ? wrapper->render : c8_wrapper_render;
+    backend->tick       = wrapper->tick ? wrapper->tick : c8_wrapper_tick;
+    backend->sound_play = wrapper->sound_play ? wrapper->sound_play : c8_wrapper_sound_play;
+    backend->sound_stop = wrapper->sound_stop ? wrapper->sound_stop : c8_wrapper_sound_stop;
+    backend->sound_pattern
+        = wrapper->sound_pattern ? wrapper->sound_pattern : c8_wrapper_sound_pattern;
+    backend->ctx   = ctx;
+    backend->input = &c8->input;
+    backend->flags = C8_BACKEND(c8)->flags;
+
+    c8->backend = backend;
+    return 0;
 }
 
 /**
- * @brief Deinitialize graphics system
+ * @brief Get the backend wrapped by a backend installed with `c8_wrap_backend`
  *
- * This function is weak and is overridden by internal/graphics_sdl.c by
- * default. This can also be overridden by the user when compiling without
- * SDL2 support.
+ * @param backend the wrapper instance
  *
- * This function should return 0 on success and a negative value on failure.
+ * @return the wrapped backend
  */
-__attribute__((weak)) int c8_deinit_graphics(void) {
-    C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "%s not implemented.", __func__);
-    return C8_GRAPHICS_EXCEPTION;
+C8_Backend* c8_wrapped_backend(C8_Backend* backend) {
+    C8_BackendWrapper* ctx = (C8_BackendWrapper*) backend->ctx;
+    return ctx->inner ? ctx->inner : &c8_nullBackend;
 }
 
 /**
- * @brief Initialize graphics system
+ * @brief Pack the active area of `display` into 1 bit per pixel
+ *
+ * Rows are `width / 8` bytes long at the current display resolution, with
+ * the leftmost pixel in the most significant bit. `out` must hold
+ * `C8_PACKED_DISPLAY_SIZE` bytes.
+ *
+ * @param display `C8_Display` to pack
+ * @param out where to store the packed pixels
+ *
+ * @return number of bytes written to `out`
+ */
+int c8_display_pack(const C8_Display* display, uint8_t* out) {
+    int size = (display->mode == C8_DISPLAYMODE_LOW)
+                   ? C8_LOW_DISPLAY_WIDTH * C8_LOW_DISPLAY_HEIGHT / 8
+                   : C8_PACKED_DISPLAY_SIZE;
+
+    for (int i = 0; i < size; i++) {
+        const uint8_t* p = &display->p[i * 8];
+        out[i]           = (p[0] << 7) | (p[1] << 6) | (p[2] << 5) | (p[3] << 4) | (p[4] << 3)
+                 | (p[5] << 2) | (p[6] << 1) | p[7];
+    }
+    return size;
+}
+
+/**
+ * @brief Convert the active area of `display` to 32-bit pixels
+ *
+ * Each pixel is a native-endian `0xAARRGGBB` word (`SDL_PIXELFORMAT_ARGB8888`)
+ * with opaque alpha, and becomes a `scale` by `scale` block, so `out` must
+ * hold `height * scale` rows of `width * scale` pixels at the current display
+ * resolution.
+ *
+ * @param display `C8_Display` to convert
+ * @param colors background and foreground colors
+ * @param out where to store the pixels
+ * @param pitch bytes from one row of `out` to the next
+ * @param scale integer scale factor
  *
- * This function is weak and is overridden by internal/graphics_sdl.c by
- * default. This can also be overridden by the user when compiling without
- * SDL2 support.
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION if `scale` or `pitch`
+ * is too small
+ */
+int c8_display_to_rgba32(
+    const C8_Display* display, const int* colors, uint32_t* out, int pitch, int scale) {
+    int width
+        = (display->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_WIDTH : C8_HIGH_DISPLAY_WIDTH;
+    int height
+        = (display->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_HEIGHT : C8_HIGH_DISPLAY_HEIGHT;
+    uint32_t bg   = 0xFF000000 | ((uint32_t) colors[0] & 0xFFFFFF);
+    uint32_t diff = bg ^ (0xFF000000 | ((uint32_t) colors[1] & 0xFFFFFF));
+    size_t   rowSize;
+
+    if (scale < 1 || pitch < width * scale * (int) sizeof(uint32_t)) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid scale %d or pitch %d", scale, pitch);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    rowSize = (size_t) width * scale * sizeof(uint32_t);
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = (uint8_t*) out + (size_t) y * scale * pitch;
+        c8_expand_row(&display->p[y * width], width, bg, diff, (uint32_t*) row, scale);
+        for (int i = 1; i < scale; i++) {
+            memcpy(row + (size_t) i * pitch, row, rowSize);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Unpack pixels packed with `c8_display_pack` into `display`
  *
- * This function should return 0 on success and a negative value on failure.
+ * @param display `C8_Display` to unpack into
+ * @param packed packed pixels
+ * @param mode display mode `packed` was packed in
  */
-__attribute__((weak)) int c8_init_graphics(void) {
-    C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "%s not implemented.", __func__);
-    return C8_GRAPHICS_EXCEPTION;
+void c8_display_unpack(C8_Display* display, const uint8_t* packed, int mode) {
+    int size = (mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_WIDTH * C8_LOW_DISPLAY_HEIGHT
+                                            : C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT;
+
+    for (int i = 0; i < size; i++) {
+        display->p[i] = (packed[i >> 3] >> (7 - (i & 7))) & 1;
+    }
+    display->mode = mode;
 }
 
 /**
- * @brief Render graphics
+ * @brief Convert `persistence` to 32-bit pixels
  *
- * This function is weak and is overridden by internal/graphics_sdl.c by
- * default. This can also be overridden by the user when compiling without
- * SDL2 support.
+ * Each pixel is blended between the background and foreground color by its
+ * intensity. The layout of `out` is the same as for `c8_display_to_rgba32`.
  *
- * This function should return 0 on success and a negative value on failure.
+ * @param persistence `C8_Persistence` to convert
+ * @param colors background and foreground colors
+ * @param out where to store the pixels
+ * @param pitch bytes from one row of `out` to the next
+ * @param scale number of times to repeat each pixel horizontally and vertically
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION if `scale` is less
+ * than 1 or `pitch` is too small
  */
-__attribute__((weak)) int c8_render(C8_Display* display, int* colors) {
-    C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "%s not implemented.", __func__);
-    return C8_GRAPHICS_EXCEPTION;
+int c8_persistence_to_rgba32(
+    const C8_Persistence* persistence, const int* colors, uint32_t* out, int pitch, int scale) {
+    int width
+        = (persistence->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_WIDTH : C8_HIGH_DISPLAY_WIDTH;
+    int height = (persistence->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_HEIGHT
+                                                           : C8_HIGH_DISPLAY_HEIGHT;
+    uint32_t lut[256];
+    size_t   rowSize;
+
+    if (scale < 1 || pitch < width * scale * (int) sizeof(uint32_t)) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid scale %d or pitch %d", scale, pitch);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        lut[i] = 0xFF000000;
+        for (int shift = 0; shift < 24; shift += 8) {
+            int bg = (colors[0] >> shift) & 0xFF;
+            int fg = (colors[1] >> shift) & 0xFF;
+            lut[i] |= (uint32_t) (bg + (fg - bg) * i / 255) << shift;
+        }
+    }
+
+    rowSize = (size_t) width * scale * sizeof(uint32_t);
+    for (int y = 0; y < height; y++) {
+        uint8_t*       row = (uint8_t*) out + (size_t) y * scale * pitch;
+        const uint8_t* in  = &persistence->i[y * width];
+        for (int x = 0; x < width; x++) {
+            for (int i = 0; i < scale; i++) {
+                ((uint32_t*) row)[x * scale + i] = lut[in[x]];
+            }
+        }
+        for (int i = 1; i < scale; i++) {
+            memcpy(row + (size_t) i * pitch, row, rowSize);
+        }
+    }
+    return 0;
 }
 
 /**
- * @brief Grab current keypresses and delay execution to match clockspeed
+ * @brief Fade `persistence` by one frame and light the pixels lit in `display`
+ *
+ * Dark pixels keep `decay / 256` of their intensity, lit pixels go to full
+ * intensity. A change of display mode resets all intensities.
  *
- * This function is weak and is overridden by internal/graphics_sdl.c by
- * default. This can also be overridden by the user when compiling without
- * SDL2 support.
+ * @param persistence `C8_Persistence` to update
+ * @param display `C8_Display` of the new frame
  *
- * This function should return -2 if quitting, -1 if no key was released, or
- * the key index of the first key released since the last call.
+ * @return 1 if any intensity changed, else 0
  */
-__attribute__((weak)) int c8_tick(int* key) {
-    C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "%s not implemented.", __func__);
-    return C8_GRAPHICS_EXCEPTION;
+int c8_persistence_update(C8_Persistence* persistence, const C8_Display* display) {
+    int      size    = (display->mode == C8_DISPLAYMODE_LOW)
+                           ? C8_LOW_DISPLAY_WIDTH * C8_LOW_DISPLAY_HEIGHT
+                           : C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT;
+    uint8_t* in      = persistence->i;
+    int      changed = 0;
+    int      x       = 0;
+
+    if (persistence->mode != display->mode) {
+        memset(in, 0, sizeof(persistence->i));
+        persistence->mode = display->mode;
+        changed           = 1;
+    }
+
+#if defined(__SSE2__)
+    const __m128i decay = _mm_set1_epi16(persistence->decay);
+    const __m128i zero  = _mm_setzero_si128();
+
+    for (; x + 16 <= size; x += 16) {
+        __m128i old = _mm_loadu_si128((const __m128i*) (in + x));
+        __m128i lit = _mm_loadu_si128((const __m128i*) (display->p + x));
+        __m128i lo  = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(old, zero), decay), 8);
+        __m128i hi  = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(old, zero), decay), 8);
+        __m128i v   = _mm_or_si128(_mm_packus_epi16(lo, hi),
+                                 _mm_andnot_si128(_mm_cmpeq_epi8(lit, zero), _mm_set1_epi8(-1)));
+        changed |= _mm_movemask_epi8(_mm_cmpeq_epi8(v, old)) != 0xFFFF;
+        _mm_storeu_si128((__m128i*) (in + x), v);
+    }
+#elif defined(__ARM_NEON)
+    const uint8x8_t decay = vdup_n_u8(persistence->decay);
+
+    for (; x + 16 <= size; x += 16) {
+        uint8x16_t old = vld1q_u8(in + x);
+        uint8x16_t lit = vld1q_u8(display->p + x);
+        uint8x8_t  lo  = vshrn_n_u16(vmull_u8(vget_low_u8(old), decay), 8);
+        uint8x8_t  hi  = vshrn_n_u16(vmull_u8(vget_high_u8(old), decay), 8);
+        uint8x16_t v   = vorrq_u8(vcombine_u8(lo, hi), vtstq_u8(lit, lit));
+        uint64x2_t ne  = vreinterpretq_u64_u8(veorq_u8(v, old));
+        changed |= (vgetq_lane_u64(ne, 0) | vgetq_lane_u64(ne, 1)) != 0;
+        vst1q_u8(in + x, v);
+    }
+#endif
+
+    for (; x < size; x++) {
+        uint8_t v = display->p[x] ? 0xFF : (uint8_t) ((in[x] * persistence->decay) >> 8);
+        changed |= v != in[x];
+        in[x] = v;
+    }
+    return changed;
 }
 
 /**
@@ -109,3 +435,182 @@ uint8_t* c8_get_pixel(C8_Display* display, int x, int y) {
     x %= width;
     return &display->p[y * width + x];
 }
+
+/**
+ * @brief Copy `backend` into the registry, replacing any backend with the same name
+ *
+ * @param backend the backend template
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION on failure
+ */
+C8_STATIC int c8_add_backend(const C8_Backend* backend) {
+    int i;
+
+    if (!backend || !backend->name) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Backend has no name");
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    for (i = 0; i < c8_backendCount; i++) {
+        if (strcmp(c8_backends[i].name, backend->name) == 0) {
+            break;
+        }
+    }
+
+    if (i == C8_MAX_BACKENDS) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Too many backends");
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    C8_Backend* b = &c8_backends[i];
+    memcpy(b, backend, sizeof(C8_Backend));
+    b->init          = b->init ? b->init : c8_null_init;
+    b->deinit        = b->deinit ? b->deinit : c8_null_init;
+    b->render        = b->render ? b->render : c8_null_render;
+    b->tick          = b->tick ? b->tick : c8_null_tick;
+    b->sound_play    = b->sound_play ? b->sound_play : c8_null_init;
+    b->sound_stop    = b->sound_stop ? b->sound_stop : c8_null_init;
+    b->sound_pattern = b->sound_pattern ? b->sound_pattern : c8_null_sound_pattern;
+
+    if (i == c8_backendCount) {
+        c8_backendCount++;
+    }
+    return 0;
+}
+
+/**
+ * @brief Do nothing
+ *
+ * Stands in for `init`, `deinit`, `sound_play` and `sound_stop`.
+ *
+ * @param backend unused
+ * @return 0
+ */
+C8_STATIC int c8_null_init(C8_Backend* backend) { return 0; }
+
+/**
+ * @brief Draw nothing
+ *
+ * @param backend unused
+ * @param display unused
+ * @param colors unused
+ * @return 0
+ */
+C8_STATIC int c8_null_render(C8_Backend* backend, C8_Display* display, int* colors) { return 0; }
+
+/**
+ * @brief Play no pattern
+ *
+ * @param backend unused
+ * @param pattern unused
+ * @param pitch unused
+ * @return 0
+ */
+C8_STATIC int c8_null_sound_pattern(C8_Backend* backend, const uint8_t* pattern, int pitch) {
+    return 0;
+}
+
+/**
+ * @brief Read no input
+ *
+ * @param backend unused
+ * @param keys unused
+ * @return -1 (no key released)
+ */
+C8_STATIC int c8_null_tick(C8_Backend* backend, uint32_t* keys) { return -1; }
+
+/**
+ * @brief Register the backends compiled into the library
+ *
+ * Run once, through `pthread_once`, before the registry is first used. Later
+ * lookups and registrations go through `c8_backendsLock`.
+ */
+C8_STATIC void c8_register_builtin_backends(void) {
+#ifdef C8_BACKEND_SDL2
+    c8_add_backend(&c8_sdl2Backend);
+#endif
+#ifdef C8_BACKEND_NCURSES
+    c8_add_backend(&c8_ncursesBackend);
+#endif
+    c8_add_backend(&c8_offscreenBackend);
+    c8_add_backend(&c8_nullBackend);
+}
+
+/**
+ * @brief Deinitialize and free the wrapped backend.
+ *
+ * @param backend the wrapper instance
+ * @return the return value of the wrapped backend's `deinit`
+ */
+C8_STATIC int c8_wrapper_deinit(C8_Backend* backend) {
+    C8_BackendWrapper* ctx = (C8_BackendWrapper*) backend->ctx;
+    int                ret = 0;
+
+    if (ctx->inner) {
+        ret = ctx->inner->deinit(ctx->inner);
+        free(ctx->inner);
+    }
+    free(ctx);
+    backend->ctx = NULL;
+    return ret;
+}
+
+/**
+ * @brief Render with the wrapped backend.
+ *
+ * @param backend the wrapper instance
+ * @param display `C8_Display` to render
+ * @param colors colors to render
+ * @return the return value of the wrapped backend's `render`
+ */
+C8_STATIC int c8_wrapper_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    C8_Backend* inner = c8_wrapped_backend(backend);
+    return inner->render(inner, display, colors);
+}
+
+/**
+ * @brief Set the pattern of the wrapped backend.
+ *
+ * @param backend the wrapper instance
+ * @param pattern `C8_AUDIO_PATTERN_SIZE` bytes of 1-bit samples
+ * @param pitch playback pitch
+ * @return the return value of the wrapped backend's `sound_pattern`
+ */
+C8_STATIC int c8_wrapper_sound_pattern(C8_Backend* backend, const uint8_t* pattern, int pitch) {
+    C8_Backend* inner = c8_wrapped_backend(backend);
+    return inner->sound_pattern(inner, pattern, pitch);
+}
+
+/**
+ * @brief Start the tone of the wrapped backend.
+ *
+ * @param backend the wrapper instance
+ * @return the return value of the wrapped backend's `sound_play`
+ */
+C8_STATIC int c8_wrapper_sound_play(C8_Backend* backend) {
+    C8_Backend* inner = c8_wrapped_backend(backend);
+    return inner->sound_play(inner);
+}
+
+/**
+ * @brief Stop the tone of the wrapped backend.
+ *
+ * @param backend the wrapper instance
+ * @return the return value of the wrapped backend's `sound_stop`
+ */
+C8_STATIC int c8_wrapper_sound_stop(C8_Backend* backend) {
+    C8_Backend* inner = c8_wrapped_backend(backend);
+    return inner->sound_stop(inner);
+}
+
+/**
+ * @brief Poll input from the wrapped backend.
+ *
+ * @param backend the wrapper instance
+ * @param keys key state bitmask
+ * @return the return value of the wrapped backend's `tick`
+ */
+C8_STATIC int c8_wrapper_tick(C8_Backend* backend, uint32_t* keys) {
+    C8_Backend* inner = c8_wrapped_backend(backend);
+    return inner->tick(inner, keys);
+}
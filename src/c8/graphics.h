@@ -3,13 +3,17 @@
  *
  * Function declarations for graphics display are here.
  *
- * Only `get_pixel` is strongly defined in graphics.c. Declarations are library
- * agnostic so a different graphics backend can be used.
+ * Rendering, input and sound go through a `C8_Backend`, picked by name at
+ * runtime. Built-in backends are `sdl2` and `ncurses` (when compiled in),
+ * `offscreen` (see offscreen.h) and `null`, and more can be added with
+ * `c8_register_backend`.
  */
 
 #ifndef C8_GRAPHICS_H
 #define C8_GRAPHICS_H
 
+#include "input.h"
+
 #include <stdint.h>
 
 /**
@@ -32,6 +36,46 @@
  */
 #define C8_HIGH_DISPLAY_HEIGHT 64
 
+/**
+ * @brief Size of a display packed with `c8_display_pack` (1 bit per pixel).
+ */
+#define C8_PACKED_DISPLAY_SIZE (C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT / 8)
+
+/**
+ * @brief Pack two pixel rows into each terminal cell with half-block glyphs (ncurses only).
+ */
+#define C8_GRAPHICS_FLAG_HALF_BLOCK 0x1
+
+/**
+ * @brief Bits of the graphics flags holding the persistence decay (0 = off, `sdl2` only).
+ */
+#define C8_GRAPHICS_PERSISTENCE_MASK 0xFF0000
+
+/**
+ * @brief Graphics flags enabling persistence with `decay` (see `C8_Persistence`).
+ */
+#define C8_GRAPHICS_PERSISTENCE(decay) (((decay) & 0xFF) << 16)
+
+/**
+ * @brief Bits of the graphics flags holding log2 of the audio buffer size (`sdl2` only).
+ */
+#define C8_GRAPHICS_AUDIO_BUFFER_MASK 0xF000000
+
+/**
+ * @brief Graphics flags selecting an audio buffer of `1 << log2` samples.
+ */
+#define C8_GRAPHICS_AUDIO_BUFFER(log2) (((log2) & 0xF) << 24)
+
+/**
+ * @brief Default audio buffer size in samples (about 6 ms at 44.1 kHz).
+ */
+#define C8_AUDIO_BUFFER_SAMPLES 256
+
+/**
+ * @brief Maximum number of registered backends.
+ */
+#define C8_MAX_BACKENDS 8
+
 /**
  * @brief Default window width.
  */
@@ -62,13 +106,56 @@ typedef struct {
     uint8_t mode; //!< Display mode (`C8_DISPLAYMODE_LOW` or `C8_DISPLAYMODE_HIGH`)
 } C8_Display;
 
-uint8_t*   c8_get_pixel(C8_Display*, int, int);
+/**
+  * @struct C8_Persistence
+  * @brief Per-pixel intensity of a display with phosphor-like persistence
+  *
+  * Lit pixels are at full intensity, and pixels that go dark fade out over
+  * a few frames instead of at once. This hides the flicker of games that
+  * erase and redraw their sprites on alternate frames.
+  */
+typedef struct {
+    uint8_t i[C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT]; //!< Intensity of each pixel (0-255)
+    uint8_t mode; //!< Display mode of `i`
+    uint8_t decay; //!< Fraction of its intensity a dark pixel keeps each frame, out of 256
+} C8_Persistence;
+
+typedef struct C8_Backend C8_Backend;
+
+/**
+  * @struct C8_Backend
+  * @brief Graphics, input and sound implementation
+  *
+  * Registered backends are templates: `c8_init_graphics` gives every `C8`
+  * its own copy, so `ctx` holds per-instance state. Functions left NULL at
+  * registration do nothing. Except for `tick`, they return 0 on success and
+  * a negative exception code on failure.
+  *
+  * `tick` may either update `keys` with `c8_input_set_key` and return the
+  * released key, or push timestamped events to `input`, which the scheduler
+  * applies at the instruction they fall on.
+  */
+struct C8_Backend {
+    const char* name; //!< Name to look the backend up by
+    int (*init)(C8_Backend*); //!< Open the output and set up `ctx`
+    int (*deinit)(C8_Backend*); //!< Release everything `init` acquired
+    int (*render)(C8_Backend*, C8_Display*, int*); //!< Present a display with its two colors
+    int (*tick)(C8_Backend*, uint32_t*); //!< Read keys, return -2 to quit, else released key or -1
+    int (*sound_play)(C8_Backend*); //!< Start the tone
+    int (*sound_stop)(C8_Backend*); //!< Stop the tone
+    int (*sound_pattern)(C8_Backend*, const uint8_t*, int); //!< Set the XO-CHIP pattern and pitch
+    void*          ctx; //!< Backend-specific state
+    C8_InputQueue* input; //!< Queue for timestamped key events (set by `c8_init_graphics`)
+    int            flags; //!< `C8_GRAPHICS_FLAG_*`, `C8_FILTER_*` and `C8_GRAPHICS_*(...)` fields
+};
 
-extern int c8_sound_play(void);
-extern int c8_sound_stop(void);
-extern int c8_deinit_graphics(void);
-extern int c8_init_graphics(void);
-extern int c8_render(C8_Display*, int*);
-extern int c8_tick(int*);
+int               c8_display_pack(const C8_Display*, uint8_t*);
+int               c8_display_to_rgba32(const C8_Display*, const int*, uint32_t*, int, int);
+void              c8_display_unpack(C8_Display*, const uint8_t*, int);
+const C8_Backend* c8_get_backend(const char*);
+uint8_t*          c8_get_pixel(C8_Display*, int, int);
+int               c8_persistence_to_rgba32(const C8_Persistence*, const int*, uint32_t*, int, int);
+int               c8_persistence_update(C8_Persistence*, const C8_Display*);
+int               c8_register_backend(const C8_Backend*);
 
 #endif
@@ -0,0 +1,98 @@
+/**
+ * @file c8/input.c
+ *
+ * Timestamped key events.
+ *
+ * Backends push events with the time they happened on the host, and the
+ * scheduler applies each one when the emulated machine reaches that time,
+ * so key presses shorter than a poll interval and several releases in one
+ * poll all reach the program, in order and with their spacing kept.
+ */
+
+#include "input.h"
+
+#include "common.h"
+
+#include <time.h>
+
+/**
+ * @brief Get the oldest event without removing it (consumer side)
+ *
+ * @param queue `C8_InputQueue` to look at
+ *
+ * @return the event, or NULL if `queue` is empty
+ */
+const C8_InputEvent* c8_input_peek(C8_InputQueue* queue) {
+    if (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == queue->tail) {
+        return NULL;
+    }
+    return &queue->events[queue->tail & (C8_INPUT_QUEUE_SIZE - 1)];
+}
+
+/**
+ * @brief Remove the oldest event (consumer side)
+ *
+ * Must only be called after `c8_input_peek` returned an event.
+ *
+ * @param queue `C8_InputQueue` to pop from
+ */
+void c8_input_pop(C8_InputQueue* queue) {
+    __atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Queue a key event (producer side)
+ *
+ * @param queue `C8_InputQueue` to push to
+ * @param key key (0x0-0xF)
+ * @param pressed 1 for key down, 0 for key up
+ * @param time when the event happened, from `c8_input_time` (or any clock
+ * the consumer uses, such as frame numbers divided by 60)
+ *
+ * @return 0 if queued, 1 if the queue is full and the event was dropped
+ */
+int c8_input_push(C8_InputQueue* queue, int key, int pressed, double time) {
+    uint32_t       head = queue->head;
+    C8_InputEvent* e;
+
+    if (head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) == C8_INPUT_QUEUE_SIZE) {
+        return 1;
+    }
+
+    e          = &queue->events[head & (C8_INPUT_QUEUE_SIZE - 1)];
+    e->time    = time;
+    e->key     = key & 0xF;
+    e->pressed = pressed != 0;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Press or release a key in a key state bitmask
+ *
+ * The update is atomic, so any thread may call this on `c8->keys` while the
+ * emulation thread is running without losing the updates of the others.
+ *
+ * @param keys key state bitmask
+ * @param key key (0x0-0xF, 16 and 17 for the debug hotkeys, or
+ * `C8_KEY_FAST_FORWARD`)
+ * @param pressed 1 for key down, 0 for key up
+ */
+void c8_input_set_key(uint32_t* keys, int key, int pressed) {
+    if (pressed) {
+        __atomic_fetch_or(keys, C8_KEY_BIT(key), __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_and(keys, ~C8_KEY_BIT(key), __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Get the time used to stamp events and to run `c8_simulate`
+ *
+ * @return monotonic time in seconds
+ */
+double c8_input_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
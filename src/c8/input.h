@@ -0,0 +1,58 @@
+/**
+ * @file c8/input.h
+ *
+ * Timestamped key events, queued by backends (or any other thread) and
+ * applied by the scheduler at the instruction they fall on, and the key
+ * state bitmask they are applied to.
+ */
+
+#ifndef C8_INPUT_H
+#define C8_INPUT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Number of events a `C8_InputQueue` can hold (power of 2).
+ */
+#define C8_INPUT_QUEUE_SIZE 64
+
+/**
+ * @brief Bit of key `key` (0x0-0xF, 16 and 17 for the debug hotkeys, or
+ * `C8_KEY_FAST_FORWARD`) in a key state bitmask.
+ */
+#define C8_KEY_BIT(key) ((uint32_t) 1 << (key))
+
+/**
+ * @brief Key that runs `c8_simulate` uncapped while it is held.
+ */
+#define C8_KEY_FAST_FORWARD 18
+
+/**
+  * @struct C8_InputEvent
+  * @brief A key going down or up
+  */
+typedef struct {
+    double time; //!< When it happened, in seconds on the `c8_input_time` clock
+    int    key; //!< Key (0x0-0xF)
+    int    pressed; //!< 1 for key down, 0 for key up
+} C8_InputEvent;
+
+/**
+  * @struct C8_InputQueue
+  * @brief Lock-free single-producer, single-consumer queue of `C8_InputEvent`s
+  *
+  * Events must be pushed in time order.
+  */
+typedef struct {
+    C8_InputEvent events[C8_INPUT_QUEUE_SIZE]; //!< Events pushed but not yet applied
+    uint32_t      head; //!< Number of events pushed (written by the producer)
+    uint32_t      tail; //!< Number of events applied (written by the consumer)
+} C8_InputQueue;
+
+const C8_InputEvent* c8_input_peek(C8_InputQueue*);
+void                 c8_input_pop(C8_InputQueue*);
+int                  c8_input_push(C8_InputQueue*, int, int, double);
+void                 c8_input_set_key(uint32_t*, int, int);
+double               c8_input_time(void);
+
+#endif
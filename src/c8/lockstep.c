@@ -0,0 +1,392 @@
+/**
+ * @file c8/lockstep.c
+ *
+ * Structure-of-arrays engine running many copies of one ROM in lockstep.
+ *
+ * Each step, every lane whose PC, and code at that PC, agree with lane 0
+ * executes the shared instruction in a single pass over the register
+ * arrays. The loops are branch-free selects over contiguous bytes so the
+ * compiler can turn them into SIMD code. Instructions that touch memory, the
+ * stack, the display or keys, as well as lanes that have diverged from lane 0
+ * (including through self-modifying code), go through `c8_parse_instruction`
+ * one lane at a time.
+ */
+
+#include "lockstep.h"
+
+#include "common.h"
+
+#include "private/exception.h"
+#include "private/instruction.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+C8_STATIC int  c8_lockstep_scalar(C8_Lockstep*, int);
+C8_STATIC void c8_lockstep_store(C8_Lockstep*, int);
+C8_STATIC int  c8_lockstep_vector(C8_Lockstep*, uint16_t);
+
+/**
+ * @brief Free all memory used by `ls`
+ *
+ * @param ls `C8_Lockstep` to free
+ */
+void c8_lockstep_deinit(C8_Lockstep* ls) {
+    free(ls->lanes);
+    free(ls->V);
+    free(ls->pc);
+    free(ls->I);
+    free(ls->dt);
+    free(ls->st);
+    free(ls->mask);
+    memset(ls, 0, sizeof(C8_Lockstep));
+}
+
+/**
+ * @brief Initialize `ls` with `count` copies of `src`
+ *
+ * Every lane starts running at `src->pc`.
+ *
+ * @param ls `C8_Lockstep` to initialize
+ * @param src `C8` to copy into every lane (usually fresh from `c8_init`)
+ * @param count number of lanes
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION on failure.
+ */
+int c8_lockstep_init(C8_Lockstep* ls, const C8* src, int count) {
+    memset(ls, 0, sizeof(C8_Lockstep));
+    if (count <= 0) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid lane count: %d", count);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    ls->count = count;
+    ls->lanes = (C8*) calloc(count, sizeof(C8));
+    ls->V     = (uint8_t*) malloc(16 * count);
+    ls->pc    = (uint16_t*) malloc(count * sizeof(uint16_t));
+    ls->I     = (uint16_t*) malloc(count * sizeof(uint16_t));
+    ls->dt    = (uint8_t*) malloc(count);
+    ls->st    = (uint8_t*) malloc(count);
+    ls->mask  = (uint8_t*) malloc(count);
+
+    if (!ls->lanes || !ls->V || !ls->pc || !ls->I || !ls->dt || !ls->st || !ls->mask) {
+        c8_lockstep_deinit(ls);
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Failed to allocate %d lanes", count);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    for (int l = 0; l < count; l++) {
+        c8_copy(&ls->lanes[l], src);
+        ls->lanes[l].running = 1;
+        c8_lockstep_store(ls, l);
+    }
+    return 0;
+}
+
+/**
+ * @brief Deliver a key release to `lane`
+ *
+ * If the lane is waiting on `LD Vx, K`, `key` is stored in `Vx` and the lane
+ * resumes on the next step.
+ *
+ * @param ls `C8_Lockstep` containing the lane
+ * @param lane lane index
+ * @param key released key (0x0-0xF)
+ */
+void c8_lockstep_key_released(C8_Lockstep* ls, int lane, int key) {
+    C8* c8 = &ls->lanes[lane];
+    if (c8->waitingForKey) {
+        C8_LOCKSTEP_V(ls, c8->VK)[lane] = key & 0xF;
+        c8->waitingForKey               = 0;
+    }
+}
+
+/**
+ * @brief Execute one instruction in every running lane
+ *
+ * Lanes waiting for a key or for the next frame (`r` quirk) are skipped. A
+ * lane that raises an exception stops running.
+ *
+ * @param ls `C8_Lockstep` to step
+ *
+ * @return 0 if success, or the exception code of the last lane that failed.
+ */
+int c8_lockstep_step(C8_Lockstep* ls) {
+    int            n      = ls->count;
+    int            ret    = 0;
+    int            vector = 0;
+    uint16_t       leader = ls->pc[0];
+    const uint8_t* code   = ls->lanes[0].mem;
+
+    /* Lanes have their own memory, so the code at `leader` must match too */
+    for (int l = 0; l < n && leader < C8_MEMSIZE - 1; l++) {
+        const C8* c8 = &ls->lanes[l];
+        ls->mask[l]  = ls->pc[l] == leader && c8->mem[leader] == code[leader]
+                   && c8->mem[leader + 1] == code[leader + 1] && c8->running
+                   && !c8->waitingForKey && !c8->waitingForDraw;
+        vector += ls->mask[l];
+    }
+
+    if (vector > 1 && !(ls->lanes[0].flags & C8_FLAG_VERBOSE)) {
+        vector = c8_lockstep_vector(ls, (code[leader] << 8) | code[leader + 1]);
+    } else {
+        vector = 0;
+    }
+
+    for (int l = 0; l < n; l++) {
+        const C8* c8 = &ls->lanes[l];
+        if ((vector && ls->mask[l]) || !c8->running || c8->waitingForKey || c8->waitingForDraw) {
+            continue;
+        }
+
+        int r = c8_lockstep_scalar(ls, l);
+        if (r < 0) {
+            ls->lanes[l].running = 0;
+            ret                  = r;
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Copy the registers of `lane` into `ls->lanes[lane]` and return it
+ *
+ * @param ls `C8_Lockstep` containing the lane
+ * @param lane lane index
+ *
+ * @return pointer to the up-to-date `C8` of `lane`
+ */
+C8* c8_lockstep_sync(C8_Lockstep* ls, int lane) {
+    C8* c8 = &ls->lanes[lane];
+    for (int i = 0; i < 16; i++) {
+        c8->V[i] = C8_LOCKSTEP_V(ls, i)[lane];
+    }
+    c8->pc = ls->pc[lane];
+    c8->I  = ls->I[lane];
+    c8->dt = ls->dt[lane];
+    c8->st = ls->st[lane];
+    return c8;
+}
+
+/**
+ * @brief Advance all lanes by one 60 Hz frame
+ *
+ * Decrements the delay and sound timers and releases lanes waiting for the
+ * next frame. Sound is not played.
+ *
+ * @param ls `C8_Lockstep` to tick
+ */
+void c8_lockstep_tick(C8_Lockstep* ls) {
+    for (int l = 0; l < ls->count; l++) {
+        ls->dt[l] -= ls->dt[l] > 0;
+        ls->st[l] -= ls->st[l] > 0;
+    }
+    for (int l = 0; l < ls->count; l++) {
+        ls->lanes[l].waitingForDraw = 0;
+    }
+}
+
+/**
+ * @brief Execute the next instruction of `lane` with `c8_parse_instruction`
+ *
+ * @param ls `C8_Lockstep` containing the lane
+ * @param lane lane index
+ *
+ * @return the return value of `c8_parse_instruction`
+ */
+C8_STATIC int c8_lockstep_scalar(C8_Lockstep* ls, int lane) {
+    C8* c8  = c8_lockstep_sync(ls, lane);
+    int ret = c8_parse_instruction(c8);
+    if (ret >= 0) {
+        c8->pc += ret;
+    }
+    c8_lockstep_store(ls, lane);
+    return ret;
+}
+
+/**
+ * @brief Copy the registers of `ls->lanes[lane]` into the register arrays
+ *
+ * @param ls `C8_Lockstep` containing the lane
+ * @param lane lane index
+ */
+C8_STATIC void c8_lockstep_store(C8_Lockstep* ls, int lane) {
+    const C8* c8 = &ls->lanes[lane];
+    for (int i = 0; i < 16; i++) {
+        C8_LOCKSTEP_V(ls, i)[lane] = c8->V[i];
+    }
+    ls->pc[lane] = c8->pc;
+    ls->I[lane]  = c8->I;
+    ls->dt[lane] = c8->dt;
+    ls->st[lane] = c8->st;
+}
+
+/**
+ * @brief Execute `in` in every lane selected by `ls->mask`
+ *
+ * Only instructions that read and write nothing but `V`, `I`, `PC` and the
+ * timers are handled here.
+ *
+ * @param ls `C8_Lockstep` to execute in
+ * @param in the instruction shared by all selected lanes
+ *
+ * @return 1 if the instruction was executed, 0 if it must be executed
+ * one lane at a time.
+ */
+C8_STATIC int c8_lockstep_vector(C8_Lockstep* ls, uint16_t in) {
+    C8_EXPAND(in);
+    const int      n     = ls->count;
+    const int      flags = ls->lanes[0].flags;
+    const uint8_t* m     = ls->mask;
+    uint16_t*      pc    = ls->pc;
+    uint8_t*       vx    = C8_LOCKSTEP_V(ls, x);
+    uint8_t*       vy    = C8_LOCKSTEP_V(ls, y);
+    uint8_t*       vf    = C8_LOCKSTEP_V(ls, 0xF);
+    uint8_t        r, f;
+
+    if (a == 0x8 && b > 0x7 && b != 0xE) {
+        return 0;
+    }
+
+    if (a == 0x8 && (flags & C8_FLAG_QUIRK_SHIFTING) && (b == 0x6 || b == 0xE)) {
+        vy = vx;
+    }
+
+    switch (a) {
+    case 0x1:
+        for (int l = 0; l < n; l++) {
+            pc[l] = m[l] ? nnn : pc[l];
+        }
+        return 1;
+    case 0x3:
+        for (int l = 0; l < n; l++) {
+            pc[l] += m[l] ? (vx[l] == kk ? 4 : 2) : 0;
+        }
+        return 1;
+    case 0x4:
+        for (int l = 0; l < n; l++) {
+            pc[l] += m[l] ? (vx[l] != kk ? 4 : 2) : 0;
+        }
+        return 1;
+    case 0x5:
+    case 0x9:
+        if (b != 0) {
+            return 0;
+        }
+        for (int l = 0; l < n; l++) {
+            pc[l] += m[l] ? (((vx[l] == vy[l]) == (a == 0x5)) ? 4 : 2) : 0;
+        }
+        return 1;
+    case 0x6:
+        for (int l = 0; l < n; l++) {
+            vx[l] = m[l] ? kk : vx[l];
+        }
+        break;
+    case 0x7:
+        for (int l = 0; l < n; l++) {
+            vx[l] += m[l] ? kk : 0;
+        }
+        break;
+    case 0x8:
+        /* One select loop per operation: every selected lane shares `b` */
+        switch (b) {
+        case 0x0:
+            for (int l = 0; l < n; l++) {
+                vx[l] = m[l] ? vy[l] : vx[l];
+            }
+            break;
+        case 0x1:
+            for (int l = 0; l < n; l++) {
+                vx[l] = m[l] ? vx[l] | vy[l] : vx[l];
+            }
+            break;
+        case 0x2:
+            for (int l = 0; l < n; l++) {
+                vx[l] = m[l] ? vx[l] & vy[l] : vx[l];
+            }
+            break;
+        case 0x3:
+            for (int l = 0; l < n; l++) {
+                vx[l] = m[l] ? vx[l] ^ vy[l] : vx[l];
+            }
+            break;
+        case 0x4:
+            for (int l = 0; l < n; l++) {
+                r     = vx[l] + vy[l];
+                f     = (vx[l] + vy[l]) > 0xFF;
+                vx[l] = m[l] ? r : vx[l];
+                vf[l] = m[l] ? f : vf[l];
+            }
+            break;
+        case 0x5:
+            for (int l = 0; l < n; l++) {
+                r     = vx[l] - vy[l];
+                f     = r <= vx[l];
+                vx[l] = m[l] ? r : vx[l];
+                vf[l] = m[l] ? f : vf[l];
+            }
+            break;
+        case 0x6:
+            for (int l = 0; l < n; l++) {
+                r     = vy[l] >> 1;
+                f     = vy[l] & 0x1;
+                vx[l] = m[l] ? r : vx[l];
+                vf[l] = m[l] ? f : vf[l];
+            }
+            break;
+        case 0x7:
+            for (int l = 0; l < n; l++) {
+                r     = vy[l] - vx[l];
+                f     = vx[l] < vy[l];
+                vx[l] = m[l] ? r : vx[l];
+                vf[l] = m[l] ? f : vf[l];
+            }
+            break;
+        case 0xE:
+            for (int l = 0; l < n; l++) {
+                r     = vy[l] << 1;
+                f     = vy[l] >> 7 & 1;
+                vx[l] = m[l] ? r : vx[l];
+                vf[l] = m[l] ? f : vf[l];
+            }
+            break;
+        default:
+            return 0;
+        }
+        if (b >= 0x1 && b <= 0x3 && (flags & C8_FLAG_QUIRK_VF_RESET)) {
+            for (int l = 0; l < n; l++) {
+                vf[l] = m[l] ? 0 : vf[l];
+            }
+        }
+        break;
+    case 0xA:
+        for (int l = 0; l < n; l++) {
+            ls->I[l] = m[l] ? nnn : ls->I[l];
+        }
+        break;
+    case 0xF:
+        if (kk == 0x07) {
+            for (int l = 0; l < n; l++) {
+                vx[l] = m[l] ? ls->dt[l] : vx[l];
+            }
+        } else if (kk == 0x15) {
+            for (int l = 0; l < n; l++) {
+                ls->dt[l] = m[l] ? vx[l] : ls->dt[l];
+            }
+        } else if (kk == 0x1E) {
+            for (int l = 0; l < n; l++) {
+                ls->I[l] += m[l] ? vx[l] : 0;
+            }
+        } else {
+            return 0;
+        }
+        break;
+    default:
+        return 0;
+    }
+
+    for (int l = 0; l < n; l++) {
+        pc[l] += m[l] ? 2 : 0;
+    }
+    return 1;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file c8/lockstep.h
+ *
+ * Structure-of-arrays engine running many copies of one ROM in lockstep.
+ */
+
+#ifndef C8_LOCKSTEP_H
+#define C8_LOCKSTEP_H
+
+#include "chip8.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Get the `V[reg]` column (one byte per lane) of a `C8_Lockstep`
+ */
+#define C8_LOCKSTEP_V(ls, reg) (&(ls)->V[(reg) * (ls)->count])
+
+/**
+  * @struct C8_Lockstep
+  * @brief Registers of `count` instances stored as contiguous arrays
+  *
+  * `V`, `pc`, `I`, `dt` and `st` are authoritative and stored per register
+  * across all lanes. Everything else (memory, stack, display, keys) lives in
+  * `lanes`, whose copies of those registers are only up to date after
+  * `c8_lockstep_sync`.
+  *
+  * All lanes must share `flags` and `mode`.
+  */
+typedef struct {
+    int       count; //!< Number of lanes
+    C8*       lanes; //!< Per-lane state other than the registers below
+    uint8_t*  V; //!< General purpose registers, `V[reg * count + lane]`
+    uint16_t* pc; //!< Program counters
+    uint16_t* I; //!< Address registers
+    uint8_t*  dt; //!< Delay timers
+    uint8_t*  st; //!< Sound timers
+    uint8_t*  mask; //!< Scratch: lanes taking part in the current vector pass
+} C8_Lockstep;
+
+void c8_lockstep_deinit(C8_Lockstep*);
+int  c8_lockstep_init(C8_Lockstep*, const C8*, int);
+void c8_lockstep_key_released(C8_Lockstep*, int, int);
+int  c8_lockstep_step(C8_Lockstep*);
+C8*  c8_lockstep_sync(C8_Lockstep*, int);
+void c8_lockstep_tick(C8_Lockstep*);
+
+#endif
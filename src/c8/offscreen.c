@@ -0,0 +1,267 @@
+/**
+ * @file c8/offscreen.c
+ *
+ * Headless `offscreen` backend that keeps frames in memory, optionally dumps
+ * them to image files, and reads input from a script.
+ *
+ * Scripts contain one event per line, `<frame> <key> down|up` or
+ * `<frame> quit`, sorted by frame. Blank lines and lines starting with `#`
+ * are ignored.
+ */
+
+#include "offscreen.h"
+
+#include "common.h"
+
+#include "private/exception.h"
+#include "private/util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+C8_STATIC int c8_offscreen_deinit(C8_Backend*);
+C8_STATIC int c8_offscreen_init(C8_Backend*);
+C8_STATIC int c8_offscreen_render(C8_Backend*, C8_Display*, int*);
+C8_STATIC int c8_offscreen_tick(C8_Backend*, uint32_t*);
+
+/**
+ * @brief The `offscreen` backend
+ */
+const C8_Backend c8_offscreenBackend = {
+    .name   = "offscreen",
+    .init   = c8_offscreen_init,
+    .deinit = c8_offscreen_deinit,
+    .render = c8_offscreen_render,
+    .tick   = c8_offscreen_tick,
+};
+
+/**
+ * @brief Get the `offscreen` state of `c8`
+ *
+ * @param c8 `C8` to get the state of
+ *
+ * @return the state, or NULL if `c8` does not use the `offscreen` backend.
+ */
+C8_Offscreen* c8_offscreen(C8* c8) {
+    if (!c8->backend || c8->backend->init != c8_offscreen_init) {
+        return NULL;
+    }
+    return (C8_Offscreen*) c8->backend->ctx;
+}
+
+/**
+ * @brief Write the latest frame of `off` to an image file
+ *
+ * @param off `C8_Offscreen` to write the frame of
+ * @param path file to write to
+ * @param format `C8_OFFSCREEN_PPM` or `C8_OFFSCREEN_PGM`
+ *
+ * @return 0 if success, C8_IO_EXCEPTION on failure
+ */
+int c8_offscreen_dump(const C8_Offscreen* off, const char* path, int format) {
+    int width
+        = (off->frame.mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_WIDTH : C8_HIGH_DISPLAY_WIDTH;
+    int height
+        = (off->frame.mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_HEIGHT : C8_HIGH_DISPLAY_HEIGHT;
+    int      channels = (format == C8_OFFSCREEN_PGM) ? 1 : 3;
+    uint8_t  row[C8_HIGH_DISPLAY_WIDTH * 3];
+    uint32_t rgba[C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT];
+
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Could not open %s", path);
+        return C8_IO_EXCEPTION;
+    }
+
+    c8_display_to_rgba32(&off->frame, off->colors, rgba, width * sizeof(uint32_t), 1);
+
+    fprintf(f, "P%d\n%d %d\n255\n", channels == 1 ? 5 : 6, width, height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t*  p = &off->frame.p[y * width];
+        const uint32_t* c = &rgba[y * width];
+        for (int x = 0; x < width; x++) {
+            if (channels == 1) {
+                row[x] = p[x] ? 0xFF : 0x00;
+            } else {
+                row[x * 3]     = (c[x] >> 16) & 0xFF;
+                row[x * 3 + 1] = (c[x] >> 8) & 0xFF;
+                row[x * 3 + 2] = c[x] & 0xFF;
+            }
+        }
+
+        if (fwrite(row, channels, width, f) != (size_t) width) {
+            fclose(f);
+            C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to write %s", path);
+            return C8_IO_EXCEPTION;
+        }
+    }
+
+    fclose(f);
+    return 0;
+}
+
+/**
+ * @brief Load an input script into `off`, replacing any previous one
+ *
+ * @param off `C8_Offscreen` to load the script into
+ * @param path script file
+ *
+ * @return 0 if success, C8_IO_EXCEPTION or C8_SYNTAX_ERROR_EXCEPTION on failure
+ */
+int c8_offscreen_load_script(C8_Offscreen* off, const char* path) {
+    char     line[64];
+    char     key[8];
+    char     action[8];
+    unsigned frame;
+    int      lineNo = 0;
+    int      n;
+    FILE*    f = fopen(path, "r");
+
+    if (!f) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Could not open input script: %s", path);
+        return C8_IO_EXCEPTION;
+    }
+
+    free(off->events);
+    off->events     = NULL;
+    off->eventCount = 0;
+    off->nextEvent  = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        C8_OffscreenEvent e;
+        lineNo++;
+
+        char* s = line + strspn(line, " \t\r\n");
+        if (*s == '\0' || *s == '#') {
+            continue;
+        }
+
+        n = sscanf(s, "%u %7s %7s", &frame, key, action);
+        if (n == 2 && strcmp(key, "quit") == 0) {
+            e.key     = C8_OFFSCREEN_QUIT;
+            e.pressed = 0;
+        } else if (n == 3 && strlen(key) == 1 && c8_hex_to_int(key[0]) >= 0
+                   && (strcmp(action, "down") == 0 || strcmp(action, "up") == 0)) {
+            e.key     = c8_hex_to_int(key[0]);
+            e.pressed = action[0] == 'd';
+        } else {
+            fclose(f);
+            C8_EXCEPTION(C8_SYNTAX_ERROR_EXCEPTION, "Invalid input script line %d", lineNo);
+            return C8_SYNTAX_ERROR_EXCEPTION;
+        }
+
+        if (off->eventCount && frame < off->events[off->eventCount - 1].frame) {
+            fclose(f);
+            C8_EXCEPTION(C8_SYNTAX_ERROR_EXCEPTION, "Input script not sorted at line %d", lineNo);
+            return C8_SYNTAX_ERROR_EXCEPTION;
+        }
+        e.frame = frame;
+
+        C8_OffscreenEvent* events
+            = realloc(off->events, (off->eventCount + 1) * sizeof(C8_OffscreenEvent));
+        if (!events) {
+            fclose(f);
+            C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to allocate input script");
+            return C8_IO_EXCEPTION;
+        }
+        off->events                    = events;
+        off->events[off->eventCount++] = e;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+/**
+ * @brief Free the state of `backend`.
+ *
+ * @param backend the backend instance
+ * @return 0
+ */
+C8_STATIC int c8_offscreen_deinit(C8_Backend* backend) {
+    C8_Offscreen* off = (C8_Offscreen*) backend->ctx;
+    if (off) {
+        free(off->events);
+        free(off);
+    }
+    backend->ctx = NULL;
+    return 0;
+}
+
+/**
+ * @brief Allocate the state of `backend`.
+ *
+ * @param backend the backend instance
+ * @return 0 if successful, C8_GRAPHICS_EXCEPTION otherwise.
+ */
+C8_STATIC int c8_offscreen_init(C8_Backend* backend) {
+    C8_Offscreen* off = calloc(1, sizeof(C8_Offscreen));
+    if (!off) {
+        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Failed to allocate offscreen context");
+        return C8_GRAPHICS_EXCEPTION;
+    }
+
+    off->dumpEvery  = 1;
+    off->dumpFormat = C8_OFFSCREEN_PPM;
+    backend->ctx    = off;
+    return 0;
+}
+
+/**
+ * @brief Keep a copy of `display` and dump it if due.
+ *
+ * @param backend the backend instance
+ * @param display `C8_Display` to render
+ * @param colors colors to render
+ * @return 0 on success, C8_IO_EXCEPTION if the frame could not be dumped
+ */
+C8_STATIC int c8_offscreen_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    C8_Offscreen* off = (C8_Offscreen*) backend->ctx;
+    unsigned      n   = off->frameCount++;
+
+    memcpy(&off->frame, display, sizeof(C8_Display));
+    off->colors[0] = colors[0];
+    off->colors[1] = colors[1];
+
+    if (off->dumpPrefix && off->dumpEvery > 0 && n % off->dumpEvery == 0) {
+        char path[4096];
+        snprintf(path,
+                 sizeof(path),
+                 "%s%06u.%s",
+                 off->dumpPrefix,
+                 n,
+                 off->dumpFormat == C8_OFFSCREEN_PGM ? "pgm" : "ppm");
+        return c8_offscreen_dump(off, path, off->dumpFormat);
+    }
+    return 0;
+}
+
+/**
+ * @brief Apply the script events that are due.
+ *
+ * At most one key release is reported per call.
+ *
+ * @param backend the backend instance
+ * @param keys key state bitmask
+ *
+ * @return -2 if quitting, -1 if no key was released, else returns value
+ * of key released.
+ */
+C8_STATIC int c8_offscreen_tick(C8_Backend* backend, uint32_t* keys) {
+    C8_Offscreen* off = (C8_Offscreen*) backend->ctx;
+
+    while (off->nextEvent < off->eventCount
+           && off->events[off->nextEvent].frame <= off->frameCount) {
+        const C8_OffscreenEvent* e = &off->events[off->nextEvent++];
+        if (e->key == C8_OFFSCREEN_QUIT) {
+            return -2;
+        }
+
+        c8_input_set_key(keys, e->key, e->pressed);
+        if (!e->pressed) {
+            return e->key;
+        }
+    }
+    return -1;
+}
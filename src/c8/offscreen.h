@@ -0,0 +1,62 @@
+/**
+ * @file c8/offscreen.h
+ *
+ * Headless `offscreen` backend that keeps frames in memory, optionally dumps
+ * them to image files, and reads input from a script.
+ */
+
+#ifndef C8_OFFSCREEN_H
+#define C8_OFFSCREEN_H
+
+#include "chip8.h"
+#include "graphics.h"
+
+/**
+ * @brief Binary PPM (P6) using the `C8` colors.
+ */
+#define C8_OFFSCREEN_PPM 0
+
+/**
+ * @brief Binary PGM (P5), lit pixels are white.
+ */
+#define C8_OFFSCREEN_PGM 1
+
+/**
+ * @brief Script event key meaning "quit".
+ */
+#define C8_OFFSCREEN_QUIT -1
+
+/**
+  * @struct C8_OffscreenEvent
+  * @brief One line of an input script
+  */
+typedef struct {
+    unsigned frame; //!< Frame at which the event happens
+    int      key; //!< Key (0x0-0xF), or `C8_OFFSCREEN_QUIT`
+    int      pressed; //!< 1 for key down, 0 for key up
+} C8_OffscreenEvent;
+
+/**
+  * @struct C8_Offscreen
+  * @brief State of an `offscreen` backend instance
+  *
+  * Get it with `c8_offscreen` after `c8_init_graphics(c8, "offscreen", 0)`
+  * and set the dump options before running.
+  */
+typedef struct {
+    C8_Display         frame; //!< Latest rendered frame
+    int                colors[2]; //!< Colors `frame` was rendered with
+    unsigned           frameCount; //!< Number of frames rendered so far
+    const char*        dumpPrefix; //!< Write frame N to `<dumpPrefix>NNNNNN.ppm/.pgm` (NULL: off)
+    int                dumpEvery; //!< Only dump every Nth frame
+    int                dumpFormat; //!< `C8_OFFSCREEN_PPM` or `C8_OFFSCREEN_PGM`
+    C8_OffscreenEvent* events; //!< Input script
+    int                eventCount; //!< Number of events in `events`
+    int                nextEvent; //!< Index of the next event to apply
+} C8_Offscreen;
+
+C8_Offscreen* c8_offscreen(C8*);
+int           c8_offscreen_dump(const C8_Offscreen*, const char*, int);
+int           c8_offscreen_load_script(C8_Offscreen*, const char*);
+
+#endif
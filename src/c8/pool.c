@@ -0,0 +1,221 @@
+/**
+ * @file c8/pool.c
+ *
+ * Preallocated storage for `C8` instances.
+ */
+
+#include "pool.h"
+
+#include "private/exception.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+C8_STATIC int c8_pool_grow(C8_Pool*);
+C8_STATIC int c8_pool_slot(const C8_Pool*, const C8*);
+
+/**
+ * @brief Branch `src` into a new `C8` taken from `pool`
+ *
+ * See `c8_copy` for what is copied. If `pool` is NULL, the clone is allocated
+ * with `calloc` and must be freed by the caller.
+ *
+ * Either way the clone has no backend, no hooks and no breakpoints.
+ *
+ * @param src `C8` to clone
+ * @param pool pool to take the clone from (may be NULL)
+ *
+ * @return pointer to the clone, or NULL if no instance could be allocated.
+ */
+C8* c8_clone(const C8* src, C8_Pool* pool) {
+    C8* c8 = pool ? c8_pool_acquire(pool) : (C8*) calloc(1, sizeof(C8));
+    if (c8) {
+        c8_copy(c8, src);
+    }
+    return c8;
+}
+
+/**
+ * @brief Take an unused `C8` from `pool`
+ *
+ * Released instances are reused first (most recently released first, while
+ * it is still in cache). Otherwise a never-used instance is zeroed and
+ * returned, and a new slab is allocated if needed. The contents of a reused
+ * instance are whatever it was released with, except for what
+ * `c8_pool_release` clears, so use `c8_copy` or `c8_reset` to give it a
+ * meaningful state.
+ *
+ * This never calls `c8_init`, and the instance should be returned with
+ * `c8_pool_release` rather than `c8_deinit`, so graphics are not touched.
+ *
+ * @param pool pool to take from
+ *
+ * @return pointer to `C8`, or NULL if a new slab could not be allocated.
+ */
+C8* c8_pool_acquire(C8_Pool* pool) {
+    if (pool->freeCount > 0) {
+        C8* c8 = pool->free[--pool->freeCount];
+        pool->released[c8_pool_slot(pool, c8)] = 0;
+        return c8;
+    }
+
+    if (pool->next == pool->end && c8_pool_grow(pool) != 0) {
+        return NULL;
+    }
+
+    C8* c8 = (C8*) pool->next;
+    pool->next += pool->stride;
+    memset(c8, 0, sizeof(C8));
+    return c8;
+}
+
+/**
+ * @brief Free all memory used by `pool`
+ *
+ * Every `C8` acquired from `pool` becomes invalid.
+ *
+ * @param pool pool to free
+ */
+void c8_pool_deinit(C8_Pool* pool) {
+    for (int i = 0; i < pool->slabCount; i++) {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    free(pool->free);
+    free(pool->released);
+    memset(pool, 0, sizeof(C8_Pool));
+}
+
+/**
+ * @brief Initialize `pool` and allocate its first slab
+ *
+ * @param pool pool to initialize
+ * @param slabSize number of instances per slab
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION if `slabSize` is
+ * invalid, C8_INVALID_STATE_EXCEPTION if the first slab could not be allocated.
+ */
+int c8_pool_init(C8_Pool* pool, int slabSize) {
+    memset(pool, 0, sizeof(C8_Pool));
+    if (slabSize <= 0) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid pool slab size: %d", slabSize);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    pool->slabSize = slabSize;
+    pool->stride   = (sizeof(C8) + C8_POOL_ALIGNMENT - 1) & ~(size_t) (C8_POOL_ALIGNMENT - 1);
+    return c8_pool_grow(pool);
+}
+
+/**
+ * @brief Return `c8` to `pool`
+ *
+ * The backend, hooks and breakpoints of `c8` are cleared and debugging is
+ * turned off, so that whoever acquires it next can never reach the contexts
+ * of this user or stop where it did. The backend is not deinitialized, that
+ * is up to the caller.
+ *
+ * @param pool pool `c8` was acquired from
+ * @param c8 `C8` to return (NULL is ignored)
+ *
+ * @return 0 if success, C8_INVALID_PARAMETER_EXCEPTION if `c8` was not
+ * acquired from `pool` or was already released.
+ */
+int c8_pool_release(C8_Pool* pool, C8* c8) {
+    if (!c8) {
+        return 0;
+    }
+
+    int slot = c8_pool_slot(pool, c8);
+    if (slot < 0 || pool->released[slot]) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "C8 is not in use from this pool");
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    c8->backend = NULL;
+    c8->flags &= ~C8_FLAG_DEBUG;
+    memset(&c8->hooks, 0, sizeof(c8->hooks));
+    memset(c8->breakpoints, 0, sizeof(c8->breakpoints));
+    pool->released[slot]          = 1;
+    pool->free[pool->freeCount++] = c8;
+    return 0;
+}
+
+/**
+ * @brief Allocate a new slab of `pool->slabSize` instances
+ *
+ * The slab is not written to here, see `C8_Pool`.
+ *
+ * @param pool pool to grow
+ *
+ * @return 0 if success, C8_INVALID_STATE_EXCEPTION on failure.
+ */
+C8_STATIC int c8_pool_grow(C8_Pool* pool) {
+    size_t bytes     = pool->stride * pool->slabSize;
+    size_t alignment = C8_POOL_ALIGNMENT;
+    void*  slab      = NULL;
+
+    if (bytes >= C8_POOL_HUGEPAGE_SIZE) {
+        alignment = C8_POOL_HUGEPAGE_SIZE;
+        bytes     = (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    void**   slabs = (void**) realloc(pool->slabs, (pool->slabCount + 1) * sizeof(void*));
+    C8**     stack = (C8**) realloc(pool->free, (pool->size + pool->slabSize) * sizeof(C8*));
+    uint8_t* flags = (uint8_t*) realloc(pool->released, pool->size + pool->slabSize);
+    if (slabs) {
+        pool->slabs = slabs;
+    }
+    if (stack) {
+        pool->free = stack;
+    }
+    if (flags) {
+        pool->released = flags;
+        memset(flags + pool->size, 0, pool->slabSize);
+    }
+
+    if (!slabs || !stack || !flags || posix_memalign(&slab, alignment, bytes) != 0) {
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION,
+                     "Failed to allocate pool slab of %d instances",
+                     pool->slabSize);
+        return C8_INVALID_STATE_EXCEPTION;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (alignment == C8_POOL_HUGEPAGE_SIZE) {
+        madvise(slab, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    pool->slabs[pool->slabCount++] = slab;
+    pool->size += pool->slabSize;
+    pool->next = (char*) slab;
+    pool->end  = (char*) slab + pool->stride * pool->slabSize;
+    return 0;
+}
+
+/**
+ * @brief Find the slot of `c8` in `pool`
+ *
+ * @param pool pool to search
+ * @param c8 `C8` to look for
+ *
+ * @return index of `c8` among all instances of `pool`, or -1 if it is not an
+ * instance of `pool` that was ever acquired.
+ */
+C8_STATIC int c8_pool_slot(const C8_Pool* pool, const C8* c8) {
+    uintptr_t p = (uintptr_t) c8;
+
+    for (int i = 0; i < pool->slabCount; i++) {
+        uintptr_t base = (uintptr_t) pool->slabs[i];
+        uintptr_t end  = i == pool->slabCount - 1 ? (uintptr_t) pool->next
+                                                   : base + pool->stride * pool->slabSize;
+
+        if (p >= base && p < end && (p - base) % pool->stride == 0) {
+            return i * pool->slabSize + (int) ((p - base) / pool->stride);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file c8/pool.h
+ *
+ * Preallocated storage for `C8` instances.
+ */
+
+#ifndef C8_POOL_H
+#define C8_POOL_H
+
+#include "chip8.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Alignment of every `C8` handed out by a pool
+ */
+#define C8_POOL_ALIGNMENT 64
+
+/**
+ * @brief Slabs at least this big are aligned to (and advised as) huge pages
+ */
+#define C8_POOL_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+/**
+  * @struct C8_Pool
+  * @brief Slab allocator for `C8` instances
+  *
+  * Instances are carved out of large slabs, one cache-aligned `C8` after
+  * another. Slab pages are not touched until an instance is first acquired,
+  * so with the kernel's first-touch policy they end up on the NUMA node of
+  * the thread acquiring them.
+  *
+  * Pools are not thread-safe. Use one pool per worker thread.
+  */
+typedef struct {
+    void**   slabs; //!< Slab allocations
+    int      slabCount; //!< Number of slabs
+    int      slabSize; //!< Instances per slab
+    size_t   stride; //!< Bytes between consecutive instances
+    char*    next; //!< Next never-used instance in the newest slab
+    char*    end; //!< End of the newest slab
+    C8**     free; //!< Stack of released instances
+    uint8_t* released; //!< 1 for each instance (by slot) that is in `free`
+    int      freeCount; //!< Number of instances in `free`
+    int      size; //!< Number of instances in all slabs
+} C8_Pool;
+
+C8*  c8_clone(const C8*, C8_Pool*);
+C8*  c8_pool_acquire(C8_Pool*);
+void c8_pool_deinit(C8_Pool*);
+int  c8_pool_init(C8_Pool*, int);
+int  c8_pool_release(C8_Pool*, C8*);
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * @file c8/private/backend.h
+ * @note NOT EXPORTED
+ *
+ * Built-in backends.
+ */
+
+#ifndef C8_BACKEND_H
+#define C8_BACKEND_H
+
+#include "../chip8.h"
+#include "../graphics.h"
+
+/**
+ * @brief Get the backend of `c8`, falling back to the null backend
+ */
+#define C8_BACKEND(c8) ((c8)->backend ? (c8)->backend : &c8_nullBackend)
+
+/**
+  * @struct C8_BackendWrapper
+  * @brief `ctx` of a backend installed by `c8_wrap_backend`
+  */
+typedef struct {
+    C8_Backend* inner; //!< Wrapped backend, or NULL for the null backend
+    void*       data; //!< State of the wrapper
+} C8_BackendWrapper;
+
+extern C8_Backend       c8_nullBackend;
+extern const C8_Backend c8_offscreenBackend;
+
+#ifdef C8_BACKEND_SDL2
+extern const C8_Backend c8_sdl2Backend;
+#endif
+
+#ifdef C8_BACKEND_NCURSES
+extern const C8_Backend c8_ncursesBackend;
+#endif
+
+int         c8_wrap_backend(C8*, const C8_Backend*, void*);
+C8_Backend* c8_wrapped_backend(C8_Backend*);
+
+#endif
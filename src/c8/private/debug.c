@@ -179,18 +179,24 @@ C8_STATIC int c8_load_flags(C8* c8, const char* path) {
 /**
  * @brief Load `C8` from file.
  *
+ * The backend and hooks of `c8` are kept.
+ *
  * @param c8 struct to load to
  * @param path path to load from
  *
  * @return 0 on success, C8_IO_EXCEPTION or C8_INVALID_STATE_EXCEPTION on failure.
  */
 C8_STATIC int c8_load_state(C8* c8, const char* path) {
-    FILE* f = fopen(path, "rb");
+    C8_Backend* backend = c8->backend;
+    C8_Hooks    hooks   = c8->hooks;
+    FILE*       f       = fopen(path, "rb");
     if (!f) {
         return C8_IO_EXCEPTION;
     }
 
-    int ret = fread(c8, sizeof(C8), 1, f);
+    int ret     = fread(c8, sizeof(C8), 1, f);
+    c8->backend = backend;
+    c8->hooks   = hooks;
     if (ret != 1) {
         fclose(f);
         return C8_IO_EXCEPTION;
@@ -43,7 +43,7 @@ const C8_Exception c8_exceptions[] = {
     { C8_AUDIO_EXCEPTION, C8_AUDIO_EXCEPTION_MESSAGE },
 };
 
-char c8_exception[C8_EXCEPTION_MESSAGE_SIZE];
+__thread char c8_exception[C8_EXCEPTION_MESSAGE_SIZE];
 
 /**
  * @brief Handles an exception by printing the corresponding error message to stderr.
@@ -40,8 +40,11 @@ typedef enum {
 
 /**
  * @brief Message to print when calling `c8_handle_exception` with a non-zero code
+ *
+ * Each thread has its own message, so instances stepped on different threads
+ * can raise exceptions at the same time.
  */
-extern char c8_exception[C8_EXCEPTION_MESSAGE_SIZE];
+extern __thread char c8_exception[C8_EXCEPTION_MESSAGE_SIZE];
 
 void        c8_handle_exception(C8_ExceptionCode);
 
@@ -2,15 +2,18 @@
  * @file c8/private/graphics_ncurses.c
  * @note NOT EXPORTED
  *
- * ncurses graphics implementation. When `NCURSES` is defined, overrides weak
- * graphics utility function definitions in `graphics.c`.
+ * ncurses backend (`ncurses`), compiled in when `NCURSES` is defined. All
+ * instances share the terminal.
  */
 
 #include "../common.h"
 #include "../graphics.h"
+#include "backend.h"
 #include "exception.h"
 
+#include <locale.h>
 #include <ncurses.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef X11
@@ -18,14 +21,39 @@
 #include <X11/Xlib.h>
 #endif
 
-C8_STATIC const int c8_keyMap[18][2] = {
-    { '1', 1 },   { '2', 2 },   { '3', 3 },   { '4', 0xC }, { 'q', 4 },  { 'w', 5 },
-    { 'e', 6 },   { 'r', 0xD }, { 'a', 7 },   { 's', 8 },   { 'd', 9 },  { 'f', 0xE },
-    { 'z', 0xA }, { 'x', 0 },   { 'c', 0xB }, { 'v', 0xF }, { 'p', 16 }, { 'm', 17 },
+#define C8_KEYMAP_SIZE 128
+
+/**
+ * CHIP-8 keycode plus one of each character below `C8_KEYMAP_SIZE`, or 0 if
+ * the key is not tracked. 'p' (16) enables debug mode / step, 'm' (17)
+ * disables it, and tab fast-forwards while held.
+ */
+C8_STATIC const uint8_t c8_keyMap[C8_KEYMAP_SIZE] = {
+    ['1'] = 0x1 + 1, ['2'] = 0x2 + 1, ['3'] = 0x3 + 1, ['4'] = 0xC + 1, ['q'] = 0x4 + 1,
+    ['w'] = 0x5 + 1, ['e'] = 0x6 + 1, ['r'] = 0xD + 1, ['a'] = 0x7 + 1, ['s'] = 0x8 + 1,
+    ['d'] = 0x9 + 1, ['f'] = 0xE + 1, ['z'] = 0xA + 1, ['x'] = 0x0 + 1, ['c'] = 0xB + 1,
+    ['v'] = 0xF + 1, ['p'] = 16 + 1,  ['m'] = 17 + 1,  ['\t'] = C8_KEY_FAST_FORWARD + 1,
 };
 
 C8_STATIC int cursor_visibility;
 
+/**
+ * Glyph for each terminal cell value in half-block mode (bit 0 is the top
+ * pixel, bit 1 the bottom one).
+ */
+C8_STATIC const char* const c8_halfBlocks[4] = { " ", "\u2580", "\u2584", "\u2588" };
+
+/**
+  * @struct C8_NcursesContext
+  * @brief Per-instance state of the ncurses backend
+  */
+typedef struct {
+    uint8_t  shadow[C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT]; //!< Cells drawn last frame
+    int      shadowValid; //!< 0 if every cell must be redrawn
+    int      shadowMode; //!< Display mode of `shadow`
+    uint32_t reported; //!< Keys this backend reported held on its last poll
+} C8_NcursesContext;
+
 #ifdef X11
 Display* x11display;
 
@@ -33,9 +61,41 @@ unsigned c8_old_xkb_delay;
 unsigned c8_old_xkb_rate;
 #endif
 
-C8_STATIC int c8_get_key(char k);
+C8_STATIC int c8_get_key(int k);
+C8_STATIC int c8_ncurses_deinit(C8_Backend*);
+C8_STATIC int c8_ncurses_init(C8_Backend*);
+C8_STATIC int c8_ncurses_render(C8_Backend*, C8_Display*, int*);
+C8_STATIC int c8_ncurses_tick(C8_Backend*, uint32_t*);
+
+/**
+ * @brief The `ncurses` backend (no sound)
+ */
+const C8_Backend c8_ncursesBackend = {
+    .name   = "ncurses",
+    .init   = c8_ncurses_init,
+    .deinit = c8_ncurses_deinit,
+    .render = c8_ncurses_render,
+    .tick   = c8_ncurses_tick,
+};
+
+/**
+ * @brief Set up the terminal and the context of `backend`.
+ *
+ * @param backend the backend instance
+ * @return 0 if successful, error code otherwise.
+ */
+C8_STATIC int c8_ncurses_init(C8_Backend* backend) {
+    C8_NcursesContext* ctx = calloc(1, sizeof(C8_NcursesContext));
+    if (!ctx) {
+        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Failed to allocate ncurses context");
+        return C8_GRAPHICS_EXCEPTION;
+    }
+
+    if (backend->flags & C8_GRAPHICS_FLAG_HALF_BLOCK) {
+        /* Half-block glyphs are written as UTF-8 */
+        setlocale(LC_ALL, "");
+    }
 
-int           c8_init_graphics(void) {
     initscr();
     cbreak();
     noecho();
@@ -47,6 +107,7 @@ int           c8_init_graphics(void) {
     if (!x11display) {
         C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Failed to open X11 display");
         endwin();
+        free(ctx);
         return C8_GRAPHICS_EXCEPTION;
     }
 
@@ -56,6 +117,7 @@ int           c8_init_graphics(void) {
     if (s != True) {
         C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Failed to set X11 auto-repeat rate");
         endwin();
+        free(ctx);
         return C8_GRAPHICS_EXCEPTION;
     }
     XFlush(x11display);
@@ -66,33 +128,17 @@ int           c8_init_graphics(void) {
     start_color();
     init_pair(1, COLOR_CYAN, COLOR_RED);
 
+    backend->ctx = ctx;
     return 0;
 }
 
 /**
- * @brief Start playing the sound.
- *
- * @return 0 if successful, error code otherwise.
- */
-int c8_sound_play(void) {
-    // TODO implement
-    return 0;
-}
-
-/**
- * @brief Stop the sound playing.
+ * @brief Restore the terminal and free the context of `backend`.
  *
- * @return 0 if successful, error code otherwise.
- */
-int c8_sound_stop(void) {
-    // TODO implement
-    return 0;
-}
-
-/**
- * @brief Deinitialize the graphics library.
+ * @param backend the backend instance
+ * @return 0
  */
-int c8_deinit_graphics(void) {
+C8_STATIC int c8_ncurses_deinit(C8_Backend* backend) {
 #ifdef X11
     XkbSetAutoRepeatRate(x11display, XkbUseCoreKbd, c8_old_xkb_rate, c8_old_xkb_delay);
     XFlush(x11display);
@@ -107,33 +153,67 @@ int c8_deinit_graphics(void) {
     echo();
     qiflush();
     endwin();
+    free(backend->ctx);
+    backend->ctx = NULL;
     return 0;
 }
 
 /**
  * Render the given display to the ncurses window.
  *
+ * Only cells that changed since the previous call are written. With
+ * `C8_GRAPHICS_FLAG_HALF_BLOCK`, each cell holds two pixel rows, halving
+ * the required terminal height.
+ *
+ * @param backend the backend instance
  * @param display `C8_Display` to render
  * @param colors colors to render (UNUSED)
  * @return 0 on success, non-zero on failure
  */
-int c8_render(C8_Display* display, int* colors) {
+C8_STATIC int c8_ncurses_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    C8_NcursesContext* ctx = (C8_NcursesContext*) backend->ctx;
+
     int display_width
         = (display->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_WIDTH : C8_HIGH_DISPLAY_WIDTH;
     int display_height
         = (display->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_HEIGHT : C8_HIGH_DISPLAY_HEIGHT;
+    int half        = backend->flags & C8_GRAPHICS_FLAG_HALF_BLOCK;
+    int cell_height = half ? display_height / 2 : display_height;
 
     int rows, cols;
     getmaxyx(stdscr, rows, cols);
 
-    if (rows < display_height || cols < display_width) {
+    if (rows < cell_height || cols < display_width) {
         C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Window too small.")
         return C8_GRAPHICS_EXCEPTION;
     }
 
-    for (int y = 0; y < display_height; y++) {
+    if (ctx->shadowMode != display->mode) {
+        ctx->shadowMode  = display->mode;
+        ctx->shadowValid = 0;
+        clear();
+    }
+
+    const uint8_t* p = display->p;
+    for (int y = 0; y < cell_height; y++) {
+        uint8_t* shadow = &ctx->shadow[y * display_width];
         for (int x = 0; x < display_width; x++) {
-            if (*c8_get_pixel(display, x, y)) {
+            uint8_t cell;
+            if (half) {
+                cell = (p[2 * y * display_width + x] & 1)
+                       | (p[(2 * y + 1) * display_width + x] & 1) << 1;
+            } else {
+                cell = p[y * display_width + x] & 1;
+            }
+
+            if (ctx->shadowValid && shadow[x] == cell) {
+                continue;
+            }
+            shadow[x] = cell;
+
+            if (half) {
+                mvaddstr(y, x, c8_halfBlocks[cell]);
+            } else if (cell) {
                 attron(A_REVERSE);
                 mvaddch(y, x, ' ');
                 attroff(A_REVERSE);
@@ -142,6 +222,7 @@ int c8_render(C8_Display* display, int* colors) {
             }
         }
     }
+    ctx->shadowValid = 1;
 
     refresh();
     return 0;
@@ -153,38 +234,51 @@ int c8_render(C8_Display* display, int* colors) {
  * If a relevant key is pressed or released (see `c8_keyMap` in this file), this
  * function will update `keys` accordingly.
  *
- * @param keys pointer to int arr of keys
+ * @param backend the backend instance
+ * @param keys key state bitmask
  *
  * @return -2 if quitting, -1 if no key was released, else returns value
  * of key released.
  */
-int c8_tick(int* keys) {
-    int released = -1;
+C8_STATIC int c8_ncurses_tick(C8_Backend* backend, uint32_t* keys) {
+    C8_NcursesContext* ctx = (C8_NcursesContext*) backend->ctx;
 
-    int current_keys[18];
-    memset(current_keys, 0, sizeof(current_keys));
+    int      released = -1;
+    uint32_t current  = 0;
+    uint32_t changed;
 
     int c = ERR;
     while ((c = getch()) != ERR) {
+        if (c == KEY_RESIZE) {
+            /* Redraw every cell on the next frame */
+            ctx->shadowValid = 0;
+            continue;
+        }
+
         int k = c8_get_key(c);
 
         if (k > -1) {
-            if (current_keys[k]) {
+            if (current & C8_KEY_BIT(k)) {
                 break; // key already processed, exit loop
             }
 
-            current_keys[k] = 1;
+            current |= C8_KEY_BIT(k);
         }
     }
 
-    for (int i = 0; i < 18; i++) {
-        if (!current_keys[i] && keys[i]) {
-            released = i;
+    /* Only touch the keys the terminal reported differently from the last
+     * poll, so keys held from another thread or process stay held */
+    changed       = ctx->reported ^ current;
+    ctx->reported = current;
+    for (int i = 0; i <= C8_KEY_FAST_FORWARD; i++) {
+        if (changed & C8_KEY_BIT(i)) {
+            c8_input_set_key(keys, i, (current & C8_KEY_BIT(i)) != 0);
+            if (i < 16 && !(current & C8_KEY_BIT(i))) {
+                released = i;
+            }
         }
     }
 
-    memcpy(keys, current_keys, sizeof(current_keys));
-
     return released;
 }
 
@@ -195,11 +289,9 @@ int c8_tick(int* keys) {
  *
  * @return the CHIP-8 keycode, or -1 if no match is found.
  */
-C8_STATIC int c8_get_key(char c) {
-    for (int i = 0; i < 18; i++) {
-        if (c8_keyMap[i][0] == c) {
-            return c8_keyMap[i][1];
-        }
+C8_STATIC int c8_get_key(int c) {
+    if (c < 0 || c >= C8_KEYMAP_SIZE) {
+        return -1;
     }
-    return -1;
+    return c8_keyMap[c] - 1;
 }
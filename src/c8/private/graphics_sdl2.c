@@ -2,182 +2,318 @@
  * @file c8/private/graphics_sdl2.c
  * @note NOT EXPORTED
  *
- * SDL2 graphics implementation. When `SDL2` is defined, overrides weak
- * graphics utility function definitions in `graphics.c`.
+ * SDL2 backend (`sdl2`), compiled in when `SDL2` is defined. Each instance
+ * opens its own window and audio device.
+ *
+ * SDL has a single event queue for the whole process. Whichever instance
+ * ticks first drains it and files every event under the window it belongs
+ * to, so each instance only sees the keys and close requests of its own
+ * window.
+ *
+ * The tone (buzzer or XO-CHIP pattern) is synthesised on SDL's audio thread
+ * by a `C8_Audio`. The sound functions only push the new state onto its
+ * lock-free queue, so they never allocate or block the emulation thread, and
+ * take effect within one audio buffer.
  */
 
+#include "../audio.h"
 #include "../common.h"
+#include "../filter.h"
 #include "../graphics.h"
+#include "../input.h"
+#include "backend.h"
 #include "exception.h"
 
 #ifdef APPLE
 #include <SDL.h>
 #include <SDL_audio.h>
-#include <SDL_mixer.h>
 #else
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_audio.h>
-#include <SDL2/SDL_mixer.h>
 #endif
+#include <pthread.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-#define C8_RGB_R(i) ((i >> 12) & 0xFF)
-#define C8_RGB_G(i) ((i >> 8) & 0xFF)
-#define C8_RGB_B(i) (i & 0xFF)
-
-#define C8_AUDIO_CHANNEL     1
 #define C8_AUDIO_SAMPLE_RATE 44100
-#define C8_AUDIO_WAVE_FREQ   440
-#define C8_AUDIO_WAVE_LENGTH C8_AUDIO_SAMPLE_RATE / C8_AUDIO_WAVE_FREQ
+#define C8_KEYMAP_SIZE       128
+#define C8_SDL2_EVENT_QUEUE  64
+#define C8_SDL2_WINDOW_DATA  "c8"
 
-C8_STATIC SDL_Window*   c8_window;
-C8_STATIC SDL_Renderer* c8_renderer;
-C8_STATIC int16_t       samples[C8_AUDIO_WAVE_LENGTH];
-C8_STATIC Mix_Chunk*    c8_wave_chunk = NULL;
+/**
+  * @struct C8_SDL2Context
+  * @brief Per-instance state of the SDL2 backend
+  */
+typedef struct {
+    SDL_Window*       window;
+    SDL_Renderer*     renderer;
+    SDL_Texture*      texture;
+    SDL_AudioDeviceID device; //!< Audio device, runs `c8_get_audio`
+    C8_Audio          audio; //!< Tone generator, fed by the emulation thread
+    C8_AudioState     sound; //!< Last state pushed to `audio`
+    C8_Display        last; //!< Display in `texture`, valid if `valid`
+    int               colors[2]; //!< Colors in `texture`
+    int               valid; //!< 1 once `texture` holds a display
+    C8_Persistence    persistence; //!< Pixel intensities, used if `persistence.decay` is not 0
+    SDL_Event         events[C8_SDL2_EVENT_QUEUE]; //!< Key events for `window` not yet ticked
+    int               eventCount; //!< Number of events in `events`
+    int               closed; //!< 1 once `window` was asked to close
+    unsigned          quits; //!< `c8_sdl2Quits` when the window was opened
+} C8_SDL2Context;
 
 /**
- * Map of all keys to track.
+ * CHIP-8 keycode plus one of each `SDL_Keycode` below `C8_KEYMAP_SIZE`, or 0
+ * if the key is not tracked. The keys used are all ASCII, so a keycode is
+ * looked up with a single index.
  *
- * * `c8_keyMap[x][0]` is `SDL_Keycode`
- * * `c8_keyMap[x][1]` is CHIP-8 keycode
- * * `c8_keyMap[16]` enables debug mode / step,
- * * `c8_keyMap[17]` disables debug mode
+ * * `c8_keyMap[SDLK_p]` enables debug mode / step,
+ * * `c8_keyMap[SDLK_m]` disables debug mode
+ * * `c8_keyMap[SDLK_TAB]` fast-forwards while held
  */
-C8_STATIC const int c8_keyMap[18][2] = {
-    { SDLK_1, 1 },   { SDLK_2, 2 },   { SDLK_3, 3 },   { SDLK_4, 0xC }, { SDLK_q, 4 },
-    { SDLK_w, 5 },   { SDLK_e, 6 },   { SDLK_r, 0xD }, { SDLK_a, 7 },   { SDLK_s, 8 },
-    { SDLK_d, 9 },   { SDLK_f, 0xE }, { SDLK_z, 0xA }, { SDLK_x, 0 },   { SDLK_c, 0xB },
-    { SDLK_v, 0xF }, { SDLK_p, 16 }, // Enter debug mode
-    { SDLK_m, 17 }, // Leave debug mode
+C8_STATIC const uint8_t c8_keyMap[C8_KEYMAP_SIZE] = {
+    [SDLK_1] = 0x1 + 1, [SDLK_2] = 0x2 + 1, [SDLK_3] = 0x3 + 1, [SDLK_4] = 0xC + 1,
+    [SDLK_q] = 0x4 + 1, [SDLK_w] = 0x5 + 1, [SDLK_e] = 0x6 + 1, [SDLK_r] = 0xD + 1,
+    [SDLK_a] = 0x7 + 1, [SDLK_s] = 0x8 + 1, [SDLK_d] = 0x9 + 1, [SDLK_f] = 0xE + 1,
+    [SDLK_z] = 0xA + 1, [SDLK_x] = 0x0 + 1, [SDLK_c] = 0xB + 1, [SDLK_v] = 0xF + 1,
+    [SDLK_p] = 16 + 1, // Enter debug mode
+    [SDLK_m] = 17 + 1, // Leave debug mode
+    [SDLK_TAB] = C8_KEY_FAST_FORWARD + 1,
 };
 
-C8_STATIC int c8_get_key(SDL_Keycode k);
+C8_STATIC void c8_get_audio(void*, Uint8*, int);
+C8_STATIC int  c8_get_key(SDL_Keycode k);
+C8_STATIC int  c8_sdl2_deinit(C8_Backend*);
+C8_STATIC void c8_sdl2_dispatch(const SDL_Event*);
+C8_STATIC int  c8_sdl2_init(C8_Backend*);
+C8_STATIC int  c8_sdl2_render(C8_Backend*, C8_Display*, int*);
+C8_STATIC int  c8_sdl2_sound_pattern(C8_Backend*, const uint8_t*, int);
+C8_STATIC int  c8_sdl2_sound_play(C8_Backend*);
+C8_STATIC int  c8_sdl2_sound_stop(C8_Backend*);
+C8_STATIC int  c8_sdl2_tick(C8_Backend*, uint32_t*);
 
 /**
- * @brief Start playing the sound.
+ * Protects `c8_sdl2Quits` and the event queues of every context, which are
+ * filled by whichever instance drains SDL's queue.
+ */
+C8_STATIC pthread_mutex_t c8_sdl2Lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Number of `SDL_QUIT` events seen. Every window open at the time closes.
+ */
+C8_STATIC unsigned c8_sdl2Quits = 0;
+
+/**
+ * @brief The `sdl2` backend
+ */
+const C8_Backend c8_sdl2Backend = {
+    .name          = "sdl2",
+    .init          = c8_sdl2_init,
+    .deinit        = c8_sdl2_deinit,
+    .render        = c8_sdl2_render,
+    .tick          = c8_sdl2_tick,
+    .sound_play    = c8_sdl2_sound_play,
+    .sound_stop    = c8_sdl2_sound_stop,
+    .sound_pattern = c8_sdl2_sound_pattern,
+};
+
+/**
+ * @brief Set the XO-CHIP pattern and pitch of the sound.
  *
- * @return 0 if successful, error code otherwise.
+ * @param backend the backend instance
+ * @param pattern `C8_AUDIO_PATTERN_SIZE` bytes of 1-bit samples
+ * @param pitch playback pitch
+ * @return 0
  */
-int c8_sound_play(void) {
-    if (c8_wave_chunk == NULL) {
-        uint32_t bytes = (uint32_t) (C8_AUDIO_WAVE_LENGTH * sizeof(int16_t));
-        c8_wave_chunk  = Mix_QuickLoad_RAW((uint8_t*) samples, bytes);
-
-        if (!c8_wave_chunk) {
-            C8_EXCEPTION(C8_AUDIO_EXCEPTION, "%s", Mix_GetError());
-            return C8_AUDIO_EXCEPTION;
-        }
-        c8_wave_chunk->volume = MIX_MAX_VOLUME / 4;
+C8_STATIC int c8_sdl2_sound_pattern(C8_Backend* backend, const uint8_t* pattern, int pitch) {
+    C8_SDL2Context* ctx = (C8_SDL2Context*) backend->ctx;
+    memcpy(ctx->sound.pattern, pattern, C8_AUDIO_PATTERN_SIZE);
+    ctx->sound.pitch      = pitch;
+    ctx->sound.patternSet = 1;
+    c8_audio_push(&ctx->audio, &ctx->sound, c8_input_time());
+    return 0;
+}
 
-        if (Mix_PlayChannel(-1, c8_wave_chunk, -1) == -1) {
-            C8_EXCEPTION(C8_AUDIO_EXCEPTION, "%s", Mix_GetError());
-            return C8_AUDIO_EXCEPTION;
-        }
-    }
+/**
+ * @brief Start playing the sound.
+ *
+ * @param backend the backend instance
+ * @return 0
+ */
+C8_STATIC int c8_sdl2_sound_play(C8_Backend* backend) {
+    C8_SDL2Context* ctx = (C8_SDL2Context*) backend->ctx;
+    ctx->sound.on       = 1;
+    c8_audio_push(&ctx->audio, &ctx->sound, c8_input_time());
     return 0;
 }
 
 /**
  * @brief Stop the sound playing.
  *
- * @return 0 if successful, error code otherwise.
+ * @param backend the backend instance
+ * @return 0
  */
-int c8_sound_stop(void) {
-    int result = Mix_HaltChannel(C8_AUDIO_CHANNEL);
-    if (c8_wave_chunk) {
-        Mix_FreeChunk(c8_wave_chunk);
-        c8_wave_chunk = NULL;
-    }
-    return result == -1 ? C8_AUDIO_EXCEPTION : 0;
+C8_STATIC int c8_sdl2_sound_stop(C8_Backend* backend) {
+    C8_SDL2Context* ctx = (C8_SDL2Context*) backend->ctx;
+    ctx->sound.on       = 0;
+    c8_audio_push(&ctx->audio, &ctx->sound, c8_input_time());
+    return 0;
 }
 
 /**
- * @brief Deinitialize the graphics library.
+ * @brief Close the window and free the context of `backend`.
+ *
+ * @param backend the backend instance
+ * @return 0
  */
-int c8_deinit_graphics(void) {
-    SDL_DestroyRenderer(c8_renderer);
-    SDL_DestroyWindow(c8_window);
-    Mix_CloseAudio();
-    SDL_Quit();
+C8_STATIC int c8_sdl2_deinit(C8_Backend* backend) {
+    C8_SDL2Context* ctx = (C8_SDL2Context*) backend->ctx;
+
+    /* No more events can be filed under this context */
+    pthread_mutex_lock(&c8_sdl2Lock);
+    SDL_SetWindowData(ctx->window, C8_SDL2_WINDOW_DATA, NULL);
+    pthread_mutex_unlock(&c8_sdl2Lock);
+
+    SDL_CloseAudioDevice(ctx->device);
+    SDL_DestroyTexture(ctx->texture);
+    SDL_DestroyRenderer(ctx->renderer);
+    SDL_DestroyWindow(ctx->window);
+    SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+    free(ctx);
+    backend->ctx = NULL;
     return 0;
 }
 
 /**
- * @brief Initialize the graphics library.
+ * @brief Open a window and set up the context of `backend`.
  *
+ * @param backend the backend instance
  * @return 0 if successful, error code otherwise.
  */
-int c8_init_graphics(void) {
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
+C8_STATIC int c8_sdl2_init(C8_Backend* backend) {
+    int             scale = c8_filter_scale(backend->flags & C8_FILTER_MASK);
+    C8_SDL2Context* ctx;
+
+    if (!scale) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION,
+                     "Unknown filter: 0x%x",
+                     backend->flags & C8_FILTER_MASK);
+        return C8_INVALID_PARAMETER_EXCEPTION;
+    }
+
+    if (!(ctx = calloc(1, sizeof(C8_SDL2Context)))) {
+        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "Failed to allocate SDL context");
+        return C8_GRAPHICS_EXCEPTION;
+    }
+
+    if (SDL_InitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
         C8_EXCEPTION(C8_GRAPHICS_EXCEPTION,
                      "Failed to initialize SDL window.\n%s\n",
                      SDL_GetError());
+        free(ctx);
         return C8_GRAPHICS_EXCEPTION;
     }
 
-    if (!(c8_window = SDL_CreateWindow("CHIP8",
-                                       SDL_WINDOWPOS_UNDEFINED,
-                                       SDL_WINDOWPOS_UNDEFINED,
-                                       C8_DEFAULT_WINDOW_WIDTH,
-                                       C8_DEFAULT_WINDOW_HEIGHT,
-                                       SDL_WINDOW_RESIZABLE))) {
+    if (!(ctx->window = SDL_CreateWindow("CHIP8",
+                                         SDL_WINDOWPOS_UNDEFINED,
+                                         SDL_WINDOWPOS_UNDEFINED,
+                                         C8_DEFAULT_WINDOW_WIDTH,
+                                         C8_DEFAULT_WINDOW_HEIGHT,
+                                         SDL_WINDOW_RESIZABLE))) {
         C8_EXCEPTION(C8_GRAPHICS_EXCEPTION,
                      "Failed to initialize SDL window.\n%s\n",
                      SDL_GetError());
-        SDL_Quit();
+        SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+        free(ctx);
         return C8_GRAPHICS_EXCEPTION;
     }
 
-    if (!(c8_renderer = SDL_CreateRenderer(c8_window, -1, SDL_RENDERER_ACCELERATED))) {
+    if (!(ctx->renderer = SDL_CreateRenderer(ctx->window, -1, SDL_RENDERER_ACCELERATED))) {
         C8_EXCEPTION(C8_GRAPHICS_EXCEPTION,
                      "Failed to initialize SDL renderer.\n%s\n",
                      SDL_GetError());
-        SDL_DestroyWindow(c8_window);
-        SDL_Quit();
+        SDL_DestroyWindow(ctx->window);
+        SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+        free(ctx);
         return C8_GRAPHICS_EXCEPTION;
     }
 
-    if (Mix_OpenAudio(C8_AUDIO_SAMPLE_RATE, AUDIO_S16SYS, 1, 4096)) {
+    /* The display is uploaded at the filter's scale and stretched by SDL_RenderCopy */
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    if (!(ctx->texture = SDL_CreateTexture(ctx->renderer,
+                                           SDL_PIXELFORMAT_ARGB8888,
+                                           SDL_TEXTUREACCESS_STREAMING,
+                                           C8_HIGH_DISPLAY_WIDTH * scale,
+                                           C8_HIGH_DISPLAY_HEIGHT * scale))) {
+        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION,
+                     "Failed to initialize SDL texture.\n%s\n",
+                     SDL_GetError());
+        SDL_DestroyRenderer(ctx->renderer);
+        SDL_DestroyWindow(ctx->window);
+        SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+        free(ctx);
+        return C8_GRAPHICS_EXCEPTION;
+    }
+
+    SDL_AudioSpec want = { 0 };
+    SDL_AudioSpec have;
+    int           log2 = (backend->flags & C8_GRAPHICS_AUDIO_BUFFER_MASK) >> 24;
+
+    want.freq     = C8_AUDIO_SAMPLE_RATE;
+    want.format   = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples  = log2 ? 1 << log2 : C8_AUDIO_BUFFER_SAMPLES;
+    want.callback = c8_get_audio;
+    want.userdata = ctx;
+    if (!(ctx->device = SDL_OpenAudioDevice(
+              NULL, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE))) {
         C8_EXCEPTION(C8_AUDIO_EXCEPTION,
-                     "Failed to initialize SDL audio mixer.\n%s\n",
+                     "Failed to open SDL audio device.\n%s\n",
                      SDL_GetError());
-        SDL_DestroyRenderer(c8_renderer);
-        SDL_DestroyWindow(c8_window);
-        SDL_Quit();
+        SDL_DestroyTexture(ctx->texture);
+        SDL_DestroyRenderer(ctx->renderer);
+        SDL_DestroyWindow(ctx->window);
+        SDL_QuitSubSystem(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+        free(ctx);
         return C8_AUDIO_EXCEPTION;
     }
 
-    Mix_AllocateChannels(1);
+    c8_audio_init(&ctx->audio, have.freq);
+    ctx->sound.pitch       = C8_AUDIO_DEFAULT_PITCH;
+    ctx->persistence.decay = (backend->flags & C8_GRAPHICS_PERSISTENCE_MASK) >> 16;
+    backend->ctx           = ctx;
 
-    for (int i = 0; i < C8_AUDIO_WAVE_LENGTH; i++) {
-        samples[i] = i < C8_AUDIO_WAVE_LENGTH / 2 ? INT16_MAX : INT16_MIN;
-    }
+    pthread_mutex_lock(&c8_sdl2Lock);
+    ctx->quits = c8_sdl2Quits;
+    SDL_SetWindowData(ctx->window, C8_SDL2_WINDOW_DATA, ctx);
+    pthread_mutex_unlock(&c8_sdl2Lock);
+
+    SDL_PauseAudioDevice(ctx->device, 0);
     return 0;
 }
 
 /**
  * Render the given display to the SDL2 window.
  *
+ * The display is converted to ARGB, through the filter selected in the
+ * backend flags, into a streaming texture which the renderer then stretches
+ * over the whole window. Only the rows that changed since the last frame,
+ * plus the `C8_FILTER_RADIUS` rows around them that the filter reads, are
+ * converted and uploaded.
+ *
+ * With persistence enabled, the faded intensities are converted instead
+ * (without filtering), and the texture is left alone once every pixel has
+ * settled.
+ *
+ * @param backend the backend instance
  * @param display `C8_Display` to render
  * @param colors colors to render
  * @return 0 on success, non-zero on failure
  */
-int c8_render(C8_Display* display, int* colors) {
-    int result = SDL_RenderClear(c8_renderer);
-    if (result == -1) {
-        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "SDL_RenderClear failed: %s", SDL_GetError());
-        return C8_GRAPHICS_EXCEPTION;
-    }
-
-    result = SDL_SetRenderDrawColor(c8_renderer,
-                                    C8_RGB_R(colors[1]),
-                                    C8_RGB_G(colors[1]),
-                                    C8_RGB_B(colors[1]),
-                                    SDL_ALPHA_OPAQUE);
-    if (result == -1) {
-        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "SDL_SetRenderDrawColor failed: %s", SDL_GetError());
-        return C8_GRAPHICS_EXCEPTION;
-    }
+C8_STATIC int c8_sdl2_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    C8_SDL2Context* ctx    = (C8_SDL2Context*) backend->ctx;
+    int             filter = backend->flags & C8_FILTER_MASK;
+    int             scale  = c8_filter_scale(filter);
 
     // Width and height of the graphics buffer to draw (not scaled to window)
     int display_width
@@ -185,79 +321,184 @@ int c8_render(C8_Display* display, int* colors) {
     int display_height
         = (display->mode == C8_DISPLAYMODE_LOW) ? C8_LOW_DISPLAY_HEIGHT : C8_HIGH_DISPLAY_HEIGHT;
 
-    int window_width, window_height;
-    SDL_GetWindowSize(c8_window, &window_width, &window_height);
-
-    int      scale_x = window_width / display_width;
-    int      scale_y = window_height / display_height;
-
-    SDL_Rect pix     = { 0, 0, scale_x, scale_y };
-
-    for (int i = 0; i < display_width; i++) {
-        for (int j = 0; j < display_height; j++) {
-            if (*c8_get_pixel(display, i, j)) {
-                pix.x  = (i % display_width) * scale_x;
-                pix.y  = (j % display_height) * scale_y;
-                result = SDL_RenderFillRect(c8_renderer, &pix);
-                if (result == -1) {
-                    C8_EXCEPTION(C8_GRAPHICS_EXCEPTION,
-                                 "SDL_SetRenderFillRect failed: %s",
-                                 SDL_GetError());
-                    return C8_GRAPHICS_EXCEPTION;
-                }
-            }
+    SDL_Rect src   = { 0, 0, display_width * scale, display_height * scale };
+    int      first = 0;
+    int      last  = display_height - 1;
+    void*    pixels;
+    int      pitch;
+
+    int unchanged = ctx->valid && ctx->last.mode == display->mode && ctx->colors[0] == colors[0]
+                    && ctx->colors[1] == colors[1];
+
+    if (ctx->persistence.decay) {
+        if (!c8_persistence_update(&ctx->persistence, display) && unchanged) {
+            first = display_height;
+        }
+    } else if (unchanged) {
+        while (first <= last
+               && !memcmp(&display->p[first * display_width],
+                          &ctx->last.p[first * display_width],
+                          display_width)) {
+            first++;
+        }
+        while (last >= first
+               && !memcmp(&display->p[last * display_width],
+                          &ctx->last.p[last * display_width],
+                          display_width)) {
+            last--;
+        }
+        /* Widen only a non-empty range: a static screen uploads nothing */
+        if (filter != C8_FILTER_NONE && first <= last) {
+            first = first - C8_FILTER_RADIUS < 0 ? 0 : first - C8_FILTER_RADIUS;
+            last  = last + C8_FILTER_RADIUS >= display_height ? display_height - 1
+                                                              : last + C8_FILTER_RADIUS;
         }
     }
 
-    result = SDL_SetRenderDrawColor(c8_renderer,
-                                    C8_RGB_R(colors[0]),
-                                    C8_RGB_G(colors[0]),
-                                    C8_RGB_B(colors[0]),
-                                    SDL_ALPHA_OPAQUE);
-    if (result == -1) {
-        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "SDL_SetRenderDrawColor failed: %s", SDL_GetError());
+    if (first <= last) {
+        SDL_Rect dirty = { 0, first * scale, src.w, (last - first + 1) * scale };
+        if (SDL_LockTexture(ctx->texture, &dirty, &pixels, &pitch) == -1) {
+            C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "SDL_LockTexture failed: %s", SDL_GetError());
+            return C8_GRAPHICS_EXCEPTION;
+        }
+
+        if (ctx->persistence.decay) {
+            c8_persistence_to_rgba32(&ctx->persistence, colors, (uint32_t*) pixels, pitch, scale);
+        } else {
+            c8_display_filter(
+                display, colors, filter, (uint32_t*) pixels, pitch, first, last - first + 1);
+        }
+        SDL_UnlockTexture(ctx->texture);
+
+        memcpy(&ctx->last, display, sizeof(C8_Display));
+        ctx->colors[0] = colors[0];
+        ctx->colors[1] = colors[1];
+        ctx->valid     = 1;
+    }
+
+    if (SDL_RenderCopy(ctx->renderer, ctx->texture, &src, NULL) == -1) {
+        C8_EXCEPTION(C8_GRAPHICS_EXCEPTION, "SDL_RenderCopy failed: %s", SDL_GetError());
         return C8_GRAPHICS_EXCEPTION;
     }
 
-    SDL_RenderPresent(c8_renderer);
+    SDL_RenderPresent(ctx->renderer);
     return 0;
 }
 
 /**
  * @brief Process keypresses.
  *
- * If a relevant key is pressed or released (see `c8_keyMap` in this file), this
- * function will update `key` accordingly.
+ * SDL's event queue is drained first, see `c8_sdl2_dispatch`. Then, if a
+ * relevant key of this window is pressed or released (see `c8_keyMap` in this
+ * file), this function will update `key` accordingly. CHIP-8 keys go through
+ * `backend->input` instead, stamped with the time of the SDL event, unless
+ * the queue is full.
  *
- * @param key pointer to int arr of keys
+ * @param backend the backend instance
+ * @param keys key state bitmask
  *
  * @return -2 if quitting, -1 if no key was released, else returns value
  * of key released.
  */
-int c8_tick(int* key) {
-    SDL_Event e;
-    int       pressed  = -1;
-    int       released = -1;
+C8_STATIC int c8_sdl2_tick(C8_Backend* backend, uint32_t* keys) {
+    C8_SDL2Context* ctx = (C8_SDL2Context*) backend->ctx;
+    SDL_Event       events[C8_SDL2_EVENT_QUEUE];
+    SDL_Event       e;
+    double          now      = c8_input_time();
+    Uint32          ticks    = SDL_GetTicks();
+    int             k        = -1;
+    int             released = -1;
+    int             count, quit;
+
+    pthread_mutex_lock(&c8_sdl2Lock);
     while (SDL_PollEvent(&e)) {
-        switch (e.type) {
-        case SDL_QUIT:
-            return -2;
-        case SDL_KEYDOWN:
-            if ((pressed = c8_get_key(e.key.keysym.sym)) != -1) {
-                key[pressed] = 1;
-            }
-            break;
-        case SDL_KEYUP:
-            if ((released = c8_get_key(e.key.keysym.sym)) != -1) {
-                key[released] = 0;
-            }
-            break;
+        c8_sdl2_dispatch(&e);
+    }
+    count = ctx->eventCount;
+    quit  = ctx->closed || ctx->quits != c8_sdl2Quits;
+    memcpy(events, ctx->events, count * sizeof(SDL_Event));
+    ctx->eventCount = 0;
+    pthread_mutex_unlock(&c8_sdl2Lock);
+
+    if (quit) {
+        return -2;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const SDL_KeyboardEvent* key = &events[i].key;
+        if (key->repeat || (k = c8_get_key(key->keysym.sym)) == -1) {
+            continue;
+        }
+
+        /* Stamp CHIP-8 keys with when SDL saw them, not when they were polled */
+        double t = now - (Uint32) (ticks - key->timestamp) / 1000.0;
+        if (k < 16 && backend->input
+            && c8_input_push(backend->input, k, key->type == SDL_KEYDOWN, t) == 0) {
+            continue;
+        }
+
+        c8_input_set_key(keys, k, key->type == SDL_KEYDOWN);
+        if (key->type == SDL_KEYUP) {
+            released = k;
         }
     }
 
     return released > 15 ? -1 : released;
 }
 
+/**
+ * @brief File `e` under the context of the window it belongs to
+ *
+ * Key events are queued, a window close request closes that window only and
+ * `SDL_QUIT` closes every window. Events of windows that are not ours are
+ * dropped. Must be called with `c8_sdl2Lock` held.
+ *
+ * @param e event taken from SDL's queue
+ */
+C8_STATIC void c8_sdl2_dispatch(const SDL_Event* e) {
+    SDL_Window*     window;
+    C8_SDL2Context* ctx;
+    Uint32          id;
+
+    switch (e->type) {
+    case SDL_QUIT:
+        c8_sdl2Quits++;
+        return;
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        id = e->key.windowID;
+        break;
+    case SDL_WINDOWEVENT:
+        id = e->window.windowID;
+        break;
+    default:
+        return;
+    }
+
+    if (!(window = SDL_GetWindowFromID(id))
+        || !(ctx = (C8_SDL2Context*) SDL_GetWindowData(window, C8_SDL2_WINDOW_DATA))) {
+        return;
+    }
+
+    if (e->type == SDL_WINDOWEVENT) {
+        ctx->closed |= e->window.event == SDL_WINDOWEVENT_CLOSE;
+    } else if (ctx->eventCount < C8_SDL2_EVENT_QUEUE) {
+        ctx->events[ctx->eventCount++] = *e;
+    }
+}
+
+/**
+ * @brief SDL audio callback, runs on SDL's audio thread.
+ *
+ * @param userdata `C8_SDL2Context`
+ * @param stream where to store the samples
+ * @param len size of `stream` in bytes
+ */
+C8_STATIC void c8_get_audio(void* userdata, Uint8* stream, int len) {
+    C8_SDL2Context* ctx = (C8_SDL2Context*) userdata;
+    c8_audio_render(&ctx->audio, (int16_t*) stream, len / (int) sizeof(int16_t), c8_input_time());
+}
+
 /**
  * @brief Convert the given SDL Keycode to a CHIP-8 keycode.
  *
@@ -266,10 +507,8 @@ int c8_tick(int* key) {
  * @return the CHIP-8 keycode, or -1 if no match is found.
  */
 C8_STATIC int c8_get_key(SDL_Keycode k) {
-    for (int i = 0; i < 18; i++) {
-        if (c8_keyMap[i][0] == k) {
-            return c8_keyMap[i][1];
-        }
+    if (k < 0 || k >= C8_KEYMAP_SIZE) {
+        return -1;
     }
-    return -1;
+    return c8_keyMap[k] - 1;
 }
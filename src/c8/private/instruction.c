@@ -12,6 +12,7 @@
 #include "../decode.h"
 #include "../font.h"
 #include "../graphics.h"
+#include "backend.h"
 #include "exception.h"
 
 #include <stdlib.h>
@@ -19,6 +20,19 @@
 
 #define C8_VERBOSE(c) (c->flags & C8_FLAG_VERBOSE)
 
+/* Add `n` times `field` of the cycle model of `c` to `c->cycles`, if it is timed in cycles */
+#define C8_ADD_CYCLES(c, n, field)                                                                 \
+    do {                                                                                           \
+        if (c->flags & C8_FLAG_CYCLES) {                                                           \
+            const C8_CycleModel* model_ = c8_cycle_model(c);                                       \
+            if (model_) {                                                                          \
+                c->cycles += (n) * model_->field;                                                  \
+            }                                                                                      \
+        }                                                                                          \
+    } while (0)
+
+#define C8_CYCLES(c, op) C8_ADD_CYCLES(c, 1, cost[op])
+
 #define C8_SCHIP_EXCLUSIVE(c)                                                                      \
     if (c->mode == C8_MODE_CHIP8) {                                                                \
         fprintf(stderr, "SCHIP instruction detected in CHIP-8 mode.\n");                           \
@@ -114,11 +128,85 @@ C8_STATIC C8_INLINE int c8_i_ld_vx_ip(C8*, uint8_t);
 C8_STATIC C8_INLINE int c8_i_ld_r_vx(C8*, uint8_t);
 C8_STATIC C8_INLINE int c8_i_ld_vx_r(C8*, uint8_t);
 
+/**
+ * Cycle tables by interpreter mode (see `C8_CycleModel`), used with
+ * `C8_FLAG_CYCLES`.
+ *
+ * * CHIP-8: COSMAC VIP machine cycles. The 1.7609 MHz CPU runs 3668 of them
+ *   per frame, of which display DMA and its interrupt take about 1100. `DRW`
+ *   shifts each sprite row into place one bit at a time.
+ * * SCHIP: tenths of an average instruction on the HP-48, which ran about 30
+ *   of them per frame but took longer for scrolls, clears and tall sprites.
+ * * XO-CHIP: counted in instructions, as Octo does.
+ */
+C8_STATIC const C8_CycleModel c8_cycleModels[3] = {
+    [C8_MODE_CHIP8] = {
+        .frame = 2568,
+        .cost  = {
+            [C8_OP_CLS] = 24, [C8_OP_RET] = 23, [C8_OP_JP_NNN] = 23, [C8_OP_CALL_NNN] = 23,
+            [C8_OP_SE_VX_KK] = 10, [C8_OP_SNE_VX_KK] = 10, [C8_OP_SE_VX_VY] = 14,
+            [C8_OP_LD_VX_KK] = 6, [C8_OP_ADD_VX_KK] = 10, [C8_OP_LD_VX_VY] = 44,
+            [C8_OP_OR_VX_VY] = 44, [C8_OP_AND_VX_VY] = 44, [C8_OP_XOR_VX_VY] = 44,
+            [C8_OP_ADD_VX_VY] = 44, [C8_OP_SUB_VX_VY] = 44, [C8_OP_SHR_VX_VY] = 44,
+            [C8_OP_SUBN_VX_VY] = 44, [C8_OP_SHL_VX_VY] = 44, [C8_OP_SNE_VX_VY] = 14,
+            [C8_OP_LD_I_NNN] = 12, [C8_OP_JP_V0_NNN] = 23, [C8_OP_RND_VX_KK] = 36,
+            [C8_OP_DRW_VX_VY_B] = 15, [C8_OP_SKP_VX] = 14, [C8_OP_SKNP_VX] = 14,
+            [C8_OP_LD_VX_DT] = 10, [C8_OP_LD_VX_K] = 10, [C8_OP_LD_DT_VX] = 10,
+            [C8_OP_LD_ST_VX] = 10, [C8_OP_ADD_I_VX] = 19, [C8_OP_LD_F_VX] = 20,
+            [C8_OP_LD_B_VX] = 160, [C8_OP_LD_IP_VX] = 14, [C8_OP_LD_VX_IP] = 14,
+        },
+        .skip      = 2,
+        .drawRow   = 10,
+        .drawShift = 2,
+        .memory    = 8,
+    },
+    [C8_MODE_SCHIP] = {
+        .frame = 300,
+        .cost  = {
+            [C8_OP_SCD_B] = 40, [C8_OP_CLS] = 20, [C8_OP_RET] = 10, [C8_OP_SCR] = 40,
+            [C8_OP_SCL] = 40, [C8_OP_EXIT] = 10, [C8_OP_LOW] = 20, [C8_OP_HIGH] = 20,
+            [C8_OP_JP_NNN] = 10, [C8_OP_CALL_NNN] = 10, [C8_OP_SE_VX_KK] = 10,
+            [C8_OP_SNE_VX_KK] = 10, [C8_OP_SE_VX_VY] = 10, [C8_OP_LD_VX_KK] = 10,
+            [C8_OP_ADD_VX_KK] = 10, [C8_OP_LD_VX_VY] = 10, [C8_OP_OR_VX_VY] = 10,
+            [C8_OP_AND_VX_VY] = 10, [C8_OP_XOR_VX_VY] = 10, [C8_OP_ADD_VX_VY] = 10,
+            [C8_OP_SUB_VX_VY] = 10, [C8_OP_SHR_VX_VY] = 10, [C8_OP_SUBN_VX_VY] = 10,
+            [C8_OP_SHL_VX_VY] = 10, [C8_OP_SNE_VX_VY] = 10, [C8_OP_LD_I_NNN] = 10,
+            [C8_OP_JP_V0_NNN] = 10, [C8_OP_RND_VX_KK] = 10, [C8_OP_DRW_VX_VY_B] = 10,
+            [C8_OP_SKP_VX] = 10, [C8_OP_SKNP_VX] = 10, [C8_OP_LD_VX_DT] = 10, [C8_OP_LD_VX_K] = 10,
+            [C8_OP_LD_DT_VX] = 10, [C8_OP_LD_ST_VX] = 10, [C8_OP_ADD_I_VX] = 10,
+            [C8_OP_LD_F_VX] = 10, [C8_OP_LD_HF_VX] = 10, [C8_OP_LD_B_VX] = 20,
+            [C8_OP_LD_IP_VX] = 10, [C8_OP_LD_VX_IP] = 10, [C8_OP_LD_R_VX] = 10,
+            [C8_OP_LD_VX_R] = 10,
+        },
+        .drawRow = 1,
+        .memory  = 1,
+    },
+};
+
+/**
+ * @brief Get the cycle table `c8` is timed with
+ *
+ * @param c8 `C8` to look at
+ *
+ * @return the `C8_CycleModel` of `c8->mode` if `C8_FLAG_CYCLES` is set and
+ * that mode has one, else NULL (instructions are counted instead)
+ */
+const C8_CycleModel* c8_cycle_model(const C8* c8) {
+    int models = (int) (sizeof(c8_cycleModels) / sizeof(c8_cycleModels[0]));
+
+    if (!(c8->flags & C8_FLAG_CYCLES) || c8->mode < 0 || c8->mode >= models
+        || c8_cycleModels[c8->mode].frame <= 0) {
+        return NULL;
+    }
+    return &c8_cycleModels[c8->mode];
+}
+
 /**
  * @brief Execute the instruction at `c8->pc`
  *
  * This function parses and executes the instruction at the current program
- * counter.
+ * counter, setting `c8->cycles` to its cost (0 unless `c8_cycle_model` has a
+ * model for `c8`).
  *
  * If verbose flag is set, this will print the instruction to `stdout` as well.
  *
@@ -130,6 +218,8 @@ int c8_parse_instruction(C8* c8) {
     uint16_t in = (((uint16_t) c8->mem[c8->pc]) << 8) | c8->mem[c8->pc + 1];
     C8_EXPAND(in);
 
+    c8->cycles = 0;
+
     if (C8_VERBOSE(c8)) {
         printf("%04x: %s\n", c8->pc, c8_decode_instruction(in, NULL));
     }
@@ -330,6 +420,7 @@ C8_STATIC C8_INLINE int c8_misc_instruction(C8* c8, uint16_t in, uint8_t x, uint
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_scd_b(C8* c8, uint8_t b) {
+    C8_CYCLES(c8, C8_OP_SCD_B);
     C8_SCHIP_EXCLUSIVE(c8);
 
     int width
@@ -339,6 +430,7 @@ C8_STATIC C8_INLINE int c8_i_scd_b(C8* c8, uint8_t b) {
 
     memcpy(c8->display.p + (width * b), c8->display.p, width * height - (width * b));
     memset(c8->display.p, 0, width * b);
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -356,6 +448,7 @@ C8_STATIC C8_INLINE int c8_i_scd_b(C8* c8, uint8_t b) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_scu_b(C8* c8, uint8_t b) {
+    C8_CYCLES(c8, C8_OP_SCU_B);
     C8_SCHIP_EXCLUSIVE(c8);
 
     int width
@@ -365,6 +458,7 @@ C8_STATIC C8_INLINE int c8_i_scu_b(C8* c8, uint8_t b) {
 
     memcpy(c8->display.p, c8->display.p + (width * b), width * height - (width * b));
     memset(c8->display.p + (width * (height - b)), 0, width * b);
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -377,7 +471,9 @@ C8_STATIC C8_INLINE int c8_i_scu_b(C8* c8, uint8_t b) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_cls(C8* c8) {
+    C8_CYCLES(c8, C8_OP_CLS);
     memset(&c8->display.p, 0, C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT);
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -394,6 +490,7 @@ C8_STATIC C8_INLINE int c8_i_cls(C8* c8) {
  * or STACK_UNDERFLOW_EXCEPTION if the stack is empty.
  */
 C8_STATIC C8_INLINE int c8_i_ret(C8* c8) {
+    C8_CYCLES(c8, C8_OP_RET);
     if (c8->sp == 0) {
         C8_EXCEPTION(C8_STACK_UNDERFLOW_EXCEPTION, "Stack underflow at %03x", c8->pc);
         return C8_STACK_UNDERFLOW_EXCEPTION;
@@ -416,6 +513,7 @@ C8_STATIC C8_INLINE int c8_i_ret(C8* c8) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_scr(C8* c8) {
+    C8_CYCLES(c8, C8_OP_SCR);
     C8_SCHIP_EXCLUSIVE(c8);
 
     int width
@@ -431,6 +529,7 @@ C8_STATIC C8_INLINE int c8_i_scr(C8* c8) {
         }
         memset(&c8->display.p[y * width], 0, 4);
     }
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -447,6 +546,7 @@ C8_STATIC C8_INLINE int c8_i_scr(C8* c8) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_scl(C8* c8) {
+    C8_CYCLES(c8, C8_OP_SCL);
     C8_SCHIP_EXCLUSIVE(c8);
 
     int width
@@ -462,6 +562,7 @@ C8_STATIC C8_INLINE int c8_i_scl(C8* c8) {
         }
         memset(&c8->display.p[y * width + width - 4], 0, 4);
     }
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -478,8 +579,10 @@ C8_STATIC C8_INLINE int c8_i_scl(C8* c8) {
  * @return 0, or C8_INVALID_INSTRUCTION_EXCEPTION if `c8` is in SCHIP mode.
  */
 C8_STATIC C8_INLINE int c8_i_exit(C8* c8) {
+    C8_CYCLES(c8, C8_OP_EXIT);
     C8_SCHIP_EXCLUSIVE(c8);
     c8->running = 0;
+    C8_HOOK(c8, C8_HOOK_EXIT, 0);
     return 0;
 }
 
@@ -497,8 +600,10 @@ C8_STATIC C8_INLINE int c8_i_exit(C8* c8) {
  * C8_INVALID_INSTRUCTION_EXCEPTION if `c8` is in CHIP-8 mode.
  */
 C8_STATIC C8_INLINE int c8_i_low(C8* c8) {
+    C8_CYCLES(c8, C8_OP_LOW);
     C8_SCHIP_EXCLUSIVE(c8);
     c8->display.mode = C8_DISPLAYMODE_LOW;
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -516,8 +621,10 @@ C8_STATIC C8_INLINE int c8_i_low(C8* c8) {
  * C8_INVALID_INSTRUCTION_EXCEPTION if `c8` is in CHIP-8 mode.
  */
 C8_STATIC C8_INLINE int c8_i_high(C8* c8) {
+    C8_CYCLES(c8, C8_OP_HIGH);
     C8_SCHIP_EXCLUSIVE(c8);
     c8->display.mode = C8_DISPLAYMODE_HIGH;
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -532,6 +639,7 @@ C8_STATIC C8_INLINE int c8_i_high(C8* c8) {
  * @return 0, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_jp_nnn(C8* c8, uint16_t nnn) {
+    C8_CYCLES(c8, C8_OP_JP_NNN);
     c8->pc = nnn;
     return 0;
 }
@@ -548,6 +656,7 @@ C8_STATIC C8_INLINE int c8_i_jp_nnn(C8* c8, uint16_t nnn) {
  * @return 0, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_call_nnn(C8* c8, uint16_t nnn) {
+    C8_CYCLES(c8, C8_OP_CALL_NNN);
     if (c8->sp >= 15) {
         C8_EXCEPTION(C8_STACK_OVERFLOW_EXCEPTION, "Stack overflow at %03x", c8->pc);
         return C8_STACK_OVERFLOW_EXCEPTION;
@@ -571,8 +680,10 @@ C8_STATIC C8_INLINE int c8_i_call_nnn(C8* c8, uint16_t nnn) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_se_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
+    C8_CYCLES(c8, C8_OP_SE_VX_KK);
     if (c8->V[x] == kk) {
         c8->pc += 2;
+        C8_ADD_CYCLES(c8, 1, skip);
     }
     return 2;
 }
@@ -590,8 +701,10 @@ C8_STATIC C8_INLINE int c8_i_se_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_sne_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
+    C8_CYCLES(c8, C8_OP_SNE_VX_KK);
     if (c8->V[x] != kk) {
         c8->pc += 2;
+        C8_ADD_CYCLES(c8, 1, skip);
     }
     return 2;
 }
@@ -609,8 +722,10 @@ C8_STATIC C8_INLINE int c8_i_sne_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_se_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_SE_VX_VY);
     if (c8->V[x] == c8->V[y]) {
         c8->pc += 2;
+        C8_ADD_CYCLES(c8, 1, skip);
     }
     return 2;
 }
@@ -631,6 +746,7 @@ C8_STATIC C8_INLINE int c8_i_se_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_i_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_LD_I_VX_VY);
     C8_XOCHIP_EXCLUSIVE(c8);
 
     for (int i = x; i <= y; i++) {
@@ -655,6 +771,7 @@ C8_STATIC C8_INLINE int c8_i_ld_i_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_vx_vy_i(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_LD_VX_VY_I);
     C8_XOCHIP_EXCLUSIVE(c8);
 
     for (int i = x; i <= y; i++) {
@@ -675,6 +792,7 @@ C8_STATIC C8_INLINE int c8_i_ld_vx_vy_i(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
+    C8_CYCLES(c8, C8_OP_LD_VX_KK);
     c8->V[x] = kk;
     return 2;
 }
@@ -691,6 +809,7 @@ C8_STATIC C8_INLINE int c8_i_ld_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_add_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
+    C8_CYCLES(c8, C8_OP_ADD_VX_KK);
     c8->V[x] += kk;
     return 2;
 }
@@ -707,6 +826,7 @@ C8_STATIC C8_INLINE int c8_i_add_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_LD_VX_VY);
     c8->V[x] = c8->V[y];
     return 2;
 }
@@ -727,6 +847,7 @@ C8_STATIC C8_INLINE int c8_i_ld_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_or_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_OR_VX_VY);
     c8->V[x] |= c8->V[y];
     C8_QUIRK_VF_RESET(c8);
     return 2;
@@ -748,6 +869,7 @@ C8_STATIC C8_INLINE int c8_i_or_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_and_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_AND_VX_VY);
     c8->V[x] &= c8->V[y];
     C8_QUIRK_VF_RESET(c8);
     return 2;
@@ -769,6 +891,7 @@ C8_STATIC C8_INLINE int c8_i_and_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_xor_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_XOR_VX_VY);
     c8->V[x] = c8->V[x] ^ c8->V[y];
     C8_QUIRK_VF_RESET(c8);
     return 2;
@@ -787,6 +910,7 @@ C8_STATIC C8_INLINE int c8_i_xor_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_add_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_ADD_VX_VY);
     uint16_t sum = c8->V[x] + c8->V[y];
     c8->V[x]     = sum;
     c8->V[0xF]   = (sum > 0xFF) ? 1 : 0;
@@ -806,6 +930,7 @@ C8_STATIC C8_INLINE int c8_i_add_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_sub_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_SUB_VX_VY);
     uint8_t result = c8->V[x] - c8->V[y];
     uint8_t vf     = result <= c8->V[x];
     c8->V[x]       = result;
@@ -842,6 +967,7 @@ void print_binary(unsigned int n) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_shr_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_SHR_VX_VY);
     C8_QUIRK_SHIFTING(c8);
     uint8_t vy = c8->V[y];
     c8->V[x]   = c8->V[y] >> 1;
@@ -862,6 +988,7 @@ C8_STATIC C8_INLINE int c8_i_shr_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_subn_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_SUBN_VX_VY);
     uint8_t vf = c8->V[x] < c8->V[y];
     c8->V[x]   = c8->V[y] - c8->V[x];
     c8->V[0xF] = vf;
@@ -886,6 +1013,7 @@ C8_STATIC C8_INLINE int c8_i_subn_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_shl_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_SHL_VX_VY);
     C8_QUIRK_SHIFTING(c8);
     uint8_t vy = c8->V[y];
     c8->V[x]   = c8->V[y] << 1;
@@ -906,8 +1034,10 @@ C8_STATIC C8_INLINE int c8_i_shl_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_sne_vx_vy(C8* c8, uint8_t x, uint8_t y) {
+    C8_CYCLES(c8, C8_OP_SNE_VX_VY);
     if (c8->V[x] != c8->V[y]) {
         c8->pc += 2;
+        C8_ADD_CYCLES(c8, 1, skip);
     }
     return 2;
 }
@@ -923,6 +1053,7 @@ C8_STATIC C8_INLINE int c8_i_sne_vx_vy(C8* c8, uint8_t x, uint8_t y) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_i_nnn(C8* c8, uint16_t nnn) {
+    C8_CYCLES(c8, C8_OP_LD_I_NNN);
     c8->I = nnn;
     return 2;
 }
@@ -941,6 +1072,7 @@ C8_STATIC C8_INLINE int c8_i_ld_i_nnn(C8* c8, uint16_t nnn) {
  * @return 0, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_jp_v0_nnn(C8* c8, uint16_t nnn) {
+    C8_CYCLES(c8, C8_OP_JP_V0_NNN);
     if (c8->flags & C8_FLAG_QUIRK_JUMPING) {
         c8->pc = nnn + c8->V[(nnn >> 8) & 0xF];
     } else {
@@ -962,6 +1094,7 @@ C8_STATIC C8_INLINE int c8_i_jp_v0_nnn(C8* c8, uint16_t nnn) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_rnd_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
+    C8_CYCLES(c8, C8_OP_RND_VX_KK);
     c8->V[x] = rand() & kk;
     return 2;
 }
@@ -983,10 +1116,11 @@ C8_STATIC C8_INLINE int c8_i_rnd_vx_kk(C8* c8, uint8_t x, uint8_t kk) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_drw_vx_vy_b(C8* c8, uint8_t x, uint8_t y, uint8_t b) {
-    uint8_t vf             = 0;
-    int     display_width  = C8_LOW_DISPLAY_WIDTH;
-    int     display_height = C8_LOW_DISPLAY_HEIGHT;
-    int     sprite_width   = 8;
+    const C8_CycleModel* model          = c8_cycle_model(c8);
+    uint8_t              vf             = 0;
+    int                  display_width  = C8_LOW_DISPLAY_WIDTH;
+    int                  display_height = C8_LOW_DISPLAY_HEIGHT;
+    int                  sprite_width   = 8;
 
     if (c8->display.mode == C8_DISPLAYMODE_HIGH) {
         if (b == 0) {
@@ -997,6 +1131,11 @@ C8_STATIC C8_INLINE int c8_i_drw_vx_vy_b(C8* c8, uint8_t x, uint8_t y, uint8_t b
         display_height = C8_HIGH_DISPLAY_HEIGHT;
     }
 
+    if (model) {
+        c8->cycles += model->cost[C8_OP_DRW_VX_VY_B]
+                    + b * (model->drawRow + (c8->V[x] & 7) * model->drawShift);
+    }
+
     for (int i = 0; i < b; i++) {
         for (int j = 0; j < sprite_width; j++) {
             int display_x = (c8->V[x] + j);
@@ -1029,6 +1168,7 @@ C8_STATIC C8_INLINE int c8_i_drw_vx_vy_b(C8* c8, uint8_t x, uint8_t y, uint8_t b
     if (c8->flags & C8_FLAG_QUIRK_VBLANK) {
         c8->waitingForDraw = 1;
     }
+    C8_HOOK(c8, C8_HOOK_DRAW, 0);
     return 2;
 }
 
@@ -1044,8 +1184,10 @@ C8_STATIC C8_INLINE int c8_i_drw_vx_vy_b(C8* c8, uint8_t x, uint8_t y, uint8_t b
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_skp_vx(C8* c8, uint8_t x) {
-    if (c8->key[c8->V[x] & 0xF]) {
+    C8_CYCLES(c8, C8_OP_SKP_VX);
+    if (__atomic_load_n(&c8->keys, __ATOMIC_RELAXED) & C8_KEY_BIT(c8->V[x] & 0xF)) {
         c8->pc += 2;
+        C8_ADD_CYCLES(c8, 1, skip);
     }
     return 2;
 }
@@ -1062,8 +1204,10 @@ C8_STATIC C8_INLINE int c8_i_skp_vx(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_sknp_vx(C8* c8, uint8_t x) {
-    if (!c8->key[c8->V[x] & 0xF]) {
+    C8_CYCLES(c8, C8_OP_SKNP_VX);
+    if (!(__atomic_load_n(&c8->keys, __ATOMIC_RELAXED) & C8_KEY_BIT(c8->V[x] & 0xF))) {
         c8->pc += 2;
+        C8_ADD_CYCLES(c8, 1, skip);
     }
     return 2;
 }
@@ -1082,6 +1226,7 @@ C8_STATIC C8_INLINE int c8_i_sknp_vx(C8* c8, uint8_t x) {
  * @return 4, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_i_word(C8* c8) {
+    C8_CYCLES(c8, C8_OP_LD_I_WORD);
     C8_XOCHIP_EXCLUSIVE(c8);
     c8->I = (c8->mem[c8->pc + 2] << 8) | c8->mem[c8->pc + 3];
     return 4;
@@ -1101,6 +1246,7 @@ C8_STATIC C8_INLINE int c8_i_ld_i_word(C8* c8) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_pln_x(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_PLN_X);
     // TODO implement
     return 2;
 }
@@ -1108,8 +1254,9 @@ C8_STATIC C8_INLINE int c8_i_pln_x(C8* c8, uint8_t x) {
 /**
  * @brief `SND` instruction (`F002`)
  *
- * This instruction stores 16 bits starting at `[I]` into the audio pattern
- * buffer.
+ * This instruction stores 16 bytes starting at `[I]` into the audio pattern
+ * buffer. From then on the sound timer plays the pattern instead of the
+ * buzzer.
  *
  * @param c8 the `C8` to execute the instruction from
  *
@@ -1119,7 +1266,15 @@ C8_STATIC C8_INLINE int c8_i_pln_x(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_snd(C8* c8) {
-    // TODO implement
+    C8_CYCLES(c8, C8_OP_SND);
+    C8_XOCHIP_EXCLUSIVE(c8);
+    C8_Backend* backend = C8_BACKEND(c8);
+
+    for (int i = 0; i < C8_AUDIO_PATTERN_SIZE; i++) {
+        c8->pattern[i] = c8->mem[(c8->I + i) & (C8_MEMSIZE - 1)];
+    }
+    c8->patternSet = 1;
+    backend->sound_pattern(backend, c8->pattern, c8->pitch);
     return 2;
 }
 
@@ -1134,6 +1289,7 @@ C8_STATIC C8_INLINE int c8_i_snd(C8* c8) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_vx_dt(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_VX_DT);
     c8->V[x] = c8->dt;
     return 2;
 }
@@ -1151,9 +1307,11 @@ C8_STATIC C8_INLINE int c8_i_ld_vx_dt(C8* c8, uint8_t x) {
  * @return 0
  */
 C8_STATIC C8_INLINE int c8_i_ld_vx_k(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_VX_K);
     // Wait for a key release
     c8->VK            = x;
     c8->waitingForKey = 1;
+    C8_HOOK(c8, C8_HOOK_WAIT_KEY, x);
     return 2;
 }
 
@@ -1168,6 +1326,7 @@ C8_STATIC C8_INLINE int c8_i_ld_vx_k(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_dt_vx(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_DT_VX);
     c8->dt = c8->V[x];
     return 2;
 }
@@ -1175,18 +1334,27 @@ C8_STATIC C8_INLINE int c8_i_ld_dt_vx(C8* c8, uint8_t x) {
 /**
  * @brief `LD ST, Vx` instruction (`Fx18`)
  *
- * This instruction sets the sound timer to the value in register Vx.
+ * This instruction sets the sound timer to the value in register Vx. The
+ * tone starts if the timer was 0 and stops if it is set to 0 (it also stops
+ * when the timer runs out). Reloading a running timer leaves the tone alone.
  *
  * @param c8 the `C8` to execute the instruction from
  * @param x the index of the register Vx (0-15)
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_st_vx(C8* c8, uint8_t x) {
-    if (c8->st == 0) {
-        c8_sound_stop();
-    }
+    C8_CYCLES(c8, C8_OP_LD_ST_VX);
+    C8_Backend* backend = C8_BACKEND(c8);
+    uint8_t     before  = c8->st;
 
     c8->st = c8->V[x];
+    if (c8->st > 0 && before == 0) {
+        backend->sound_play(backend);
+        C8_HOOK(c8, C8_HOOK_SOUND_START, c8->st);
+    } else if (c8->st == 0 && before > 0) {
+        backend->sound_stop(backend);
+        C8_HOOK(c8, C8_HOOK_SOUND_STOP, 0);
+    }
     return 2;
 }
 
@@ -1201,6 +1369,7 @@ C8_STATIC C8_INLINE int c8_i_ld_st_vx(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_add_i_vx(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_ADD_I_VX);
     c8->I += c8->V[x];
     return 2;
 }
@@ -1219,6 +1388,7 @@ C8_STATIC C8_INLINE int c8_i_add_i_vx(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_f_vx(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_F_VX);
     c8->I = C8_FONT_START + ((c8->V[x] & 0xF) * 5);
     return 2;
 }
@@ -1240,6 +1410,7 @@ C8_STATIC C8_INLINE int c8_i_ld_f_vx(C8* c8, uint8_t x) {
  * `C8_INVALID_INSTRUCTION_EXCEPTION` if `c8` is in CHIP-8 mode.
  */
 C8_STATIC C8_INLINE int c8_i_ld_hf_vx(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_HF_VX);
     C8_SCHIP_EXCLUSIVE(c8);
 
     c8->I = C8_HIGH_FONT_START + (c8->V[x] * 10);
@@ -1259,6 +1430,7 @@ C8_STATIC C8_INLINE int c8_i_ld_hf_vx(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_b_vx(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_B_VX);
     c8->mem[c8->I]     = (c8->V[x] / 100) % 10; // hundreds
     c8->mem[c8->I + 1] = (c8->V[x] / 10) % 10; // tens
     c8->mem[c8->I + 2] = c8->V[x] % 10; // ones
@@ -1279,7 +1451,14 @@ C8_STATIC C8_INLINE int c8_i_ld_b_vx(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_pit_x(C8* c8, uint8_t x) {
-    // TODO implement
+    C8_CYCLES(c8, C8_OP_PIT_X);
+    C8_XOCHIP_EXCLUSIVE(c8);
+    C8_Backend* backend = C8_BACKEND(c8);
+
+    c8->pitch = c8->V[x];
+    if (c8->patternSet) {
+        backend->sound_pattern(backend, c8->pattern, c8->pitch);
+    }
     return 2;
 }
 
@@ -1295,6 +1474,8 @@ C8_STATIC C8_INLINE int c8_i_pit_x(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_ip_vx(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_IP_VX);
+    C8_ADD_CYCLES(c8, x + 1, memory);
     for (int i = 0; i < x + 1; i++) {
         c8->mem[c8->I + i] = c8->V[i];
     }
@@ -1314,6 +1495,8 @@ C8_STATIC C8_INLINE int c8_i_ld_ip_vx(C8* c8, uint8_t x) {
  * @return 2, the number of bytes to increase the program counter by.
  */
 C8_STATIC C8_INLINE int c8_i_ld_vx_ip(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_VX_IP);
+    C8_ADD_CYCLES(c8, x + 1, memory);
     for (int i = 0; i < x + 1; i++) {
         c8->V[i] = c8->mem[c8->I + i];
     }
@@ -1337,6 +1520,8 @@ C8_STATIC C8_INLINE int c8_i_ld_vx_ip(C8* c8, uint8_t x) {
  * or C8_INVALID_INSTRUCTION_EXCEPTION if `c8` is in CHIP-8 mode.
  */
 C8_STATIC C8_INLINE int c8_i_ld_r_vx(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_R_VX);
+    C8_ADD_CYCLES(c8, x, memory);
     C8_SCHIP_EXCLUSIVE(c8);
     for (int i = 0; i < x; i++) {
         c8->R[i] = c8->V[i];
@@ -1360,6 +1545,8 @@ C8_STATIC C8_INLINE int c8_i_ld_r_vx(C8* c8, uint8_t x) {
  * or C8_INVALID_INSTRUCTION_EXCEPTION if `c8` is in CHIP-8 mode.
  */
 C8_STATIC C8_INLINE int c8_i_ld_vx_r(C8* c8, uint8_t x) {
+    C8_CYCLES(c8, C8_OP_LD_VX_R);
+    C8_ADD_CYCLES(c8, x, memory);
     C8_SCHIP_EXCLUSIVE(c8);
 
     for (int i = 0; i < x; i++) {
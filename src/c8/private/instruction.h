@@ -11,6 +11,80 @@
 
 #include "../chip8.h"
 
-int c8_parse_instruction(C8* c8);
+/**
+ * @brief Instructions, one per `c8_i_*` function, indexing `C8_CycleModel.cost`
+ */
+enum {
+    C8_OP_SCD_B,
+    C8_OP_SCU_B,
+    C8_OP_CLS,
+    C8_OP_RET,
+    C8_OP_SCR,
+    C8_OP_SCL,
+    C8_OP_EXIT,
+    C8_OP_LOW,
+    C8_OP_HIGH,
+    C8_OP_JP_NNN,
+    C8_OP_CALL_NNN,
+    C8_OP_SE_VX_KK,
+    C8_OP_SNE_VX_KK,
+    C8_OP_SE_VX_VY,
+    C8_OP_LD_I_VX_VY,
+    C8_OP_LD_VX_VY_I,
+    C8_OP_LD_VX_KK,
+    C8_OP_ADD_VX_KK,
+    C8_OP_LD_VX_VY,
+    C8_OP_OR_VX_VY,
+    C8_OP_AND_VX_VY,
+    C8_OP_XOR_VX_VY,
+    C8_OP_ADD_VX_VY,
+    C8_OP_SUB_VX_VY,
+    C8_OP_SHR_VX_VY,
+    C8_OP_SUBN_VX_VY,
+    C8_OP_SHL_VX_VY,
+    C8_OP_SNE_VX_VY,
+    C8_OP_LD_I_NNN,
+    C8_OP_JP_V0_NNN,
+    C8_OP_RND_VX_KK,
+    C8_OP_DRW_VX_VY_B,
+    C8_OP_SKP_VX,
+    C8_OP_SKNP_VX,
+    C8_OP_LD_I_WORD,
+    C8_OP_PLN_X,
+    C8_OP_SND,
+    C8_OP_LD_VX_DT,
+    C8_OP_LD_VX_K,
+    C8_OP_LD_DT_VX,
+    C8_OP_LD_ST_VX,
+    C8_OP_ADD_I_VX,
+    C8_OP_LD_F_VX,
+    C8_OP_LD_HF_VX,
+    C8_OP_LD_B_VX,
+    C8_OP_PIT_X,
+    C8_OP_LD_IP_VX,
+    C8_OP_LD_VX_IP,
+    C8_OP_LD_R_VX,
+    C8_OP_LD_VX_R,
+    C8_OP_COUNT
+};
+
+/**
+  * @struct C8_CycleModel
+  * @brief Cost in machine cycles of each instruction on one original interpreter
+  *
+  * Each `c8_i_*` function adds its `cost` (and any extra below) to
+  * `c8->cycles`. Costs only have to be right relative to `frame`.
+  */
+typedef struct {
+    int frame; //!< Cycles per 60 Hz frame, or 0 to count instructions instead
+    int cost[C8_OP_COUNT]; //!< Cost of each `C8_OP_*`
+    int skip; //!< Extra cost of a skip instruction that skips
+    int drawRow; //!< Extra `DRW` cost per sprite row
+    int drawShift; //!< Extra `DRW` cost per sprite row and bit `Vx` is off a byte boundary
+    int memory; //!< Extra `Fx55`, `Fx65`, `Fx75` and `Fx85` cost per register
+} C8_CycleModel;
+
+const C8_CycleModel* c8_cycle_model(const C8*);
+int                  c8_parse_instruction(C8* c8);
 
 #endif
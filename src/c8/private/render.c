@@ -0,0 +1,105 @@
+/**
+ * @file c8/private/render.c
+ * @note NOT EXPORTED
+ *
+ * Triple-buffered frame handoff between the emulation and render threads.
+ */
+
+#include "render.h"
+
+#include "backend.h"
+#include "exception.h"
+
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * @brief Get the newest published frame, if there is one
+ *
+ * @param tb `C8_TripleBuffer` to read from
+ *
+ * @return the frame, or NULL if nothing was published since the last call.
+ * The frame stays valid until the next call.
+ */
+const C8_Display* c8_triple_buffer_acquire(C8_TripleBuffer* tb) {
+    if (!(__atomic_load_n(&tb->middle, __ATOMIC_ACQUIRE) & C8_TRIPLE_BUFFER_FRESH)) {
+        return NULL;
+    }
+
+    tb->front = __atomic_exchange_n(&tb->middle, tb->front, __ATOMIC_ACQ_REL) & 0x3;
+    return &tb->frames[tb->front];
+}
+
+/**
+ * @brief Initialize `tb` with no published frame
+ *
+ * @param tb `C8_TripleBuffer` to initialize
+ */
+void c8_triple_buffer_init(C8_TripleBuffer* tb) {
+    memset(tb, 0, sizeof(C8_TripleBuffer));
+    tb->back     = 0;
+    tb->middle   = 1;
+    tb->front    = 2;
+    tb->released = -1;
+}
+
+/**
+ * @brief Publish a copy of `display`, replacing any unread frame
+ *
+ * @param tb `C8_TripleBuffer` to write to
+ * @param display frame to publish
+ */
+void c8_triple_buffer_publish(C8_TripleBuffer* tb, const C8_Display* display) {
+    memcpy(&tb->frames[tb->back], display, sizeof(C8_Display));
+    tb->back = __atomic_exchange_n(&tb->middle, tb->back | C8_TRIPLE_BUFFER_FRESH, __ATOMIC_ACQ_REL)
+               & 0x3;
+}
+
+/**
+ * @brief Take the last key released on the render thread
+ *
+ * @param tb `C8_TripleBuffer` shared with the render thread
+ *
+ * @return the key, or -1 if none was released since the last call.
+ */
+int c8_triple_buffer_take_key(C8_TripleBuffer* tb) {
+    return __atomic_exchange_n(&tb->released, -1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief Present frames from `tb` and poll input until `c8` stops running
+ *
+ * Runs on the thread that initialized the graphics library. Backends update
+ * `c8->keys` atomically from here, released keys are handed to the emulation thread
+ * through `tb`, and quitting clears `c8->running`.
+ *
+ * @param c8 `C8` running on the emulation thread
+ * @param tb `C8_TripleBuffer` the emulation thread publishes to
+ *
+ * @return 0 if success, C8_GRAPHICS_EXCEPTION on failure
+ */
+int c8_render_loop(C8* c8, C8_TripleBuffer* tb) {
+    C8_Backend* backend = C8_BACKEND(c8);
+
+    while (__atomic_load_n(&c8->running, __ATOMIC_ACQUIRE)) {
+        int t = backend->tick(backend, &c8->keys);
+
+        if (t == -2) {
+            /* Quit */
+            __atomic_store_n(&c8->running, 0, __ATOMIC_RELEASE);
+            break;
+        }
+
+        if (t >= 0) {
+            __atomic_store_n(&tb->released, t, __ATOMIC_RELEASE);
+        }
+
+        const C8_Display* frame = c8_triple_buffer_acquire(tb);
+        if (!frame) {
+            usleep(C8_RENDER_POLL_INTERVAL);
+        } else if (backend->render(backend, (C8_Display*) frame, c8->colors) < 0) {
+            return C8_GRAPHICS_EXCEPTION;
+        }
+    }
+    return 0;
+}
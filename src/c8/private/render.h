@@ -0,0 +1,46 @@
+/**
+ * @file c8/private/render.h
+ * @note NOT EXPORTED
+ *
+ * Triple-buffered frame handoff between the emulation and render threads.
+ */
+
+#ifndef C8_RENDER_H
+#define C8_RENDER_H
+
+#include "../chip8.h"
+#include "../graphics.h"
+
+/**
+ * @brief Set in `C8_TripleBuffer.middle` when it holds an unread frame
+ */
+#define C8_TRIPLE_BUFFER_FRESH 0x4
+
+/**
+ * @brief How long the render thread sleeps when no new frame is ready (us)
+ */
+#define C8_RENDER_POLL_INTERVAL 1000
+
+/**
+  * @struct C8_TripleBuffer
+  * @brief Lock-free single producer, single consumer frame handoff
+  *
+  * The writer owns `frames[back]`, the reader owns `frames[front]` and the
+  * third frame is swapped between them through `middle`. Neither side ever
+  * waits, and frames the reader had no time for are overwritten.
+  */
+typedef struct {
+    C8_Display frames[3]; //!< Frame storage
+    int        back; //!< Index of the frame being written (writer only)
+    int        front; //!< Index of the frame being presented (reader only)
+    int        middle; //!< Index of the shared frame, or'd with `C8_TRIPLE_BUFFER_FRESH`
+    int        released; //!< Last key released on the render thread, or -1
+} C8_TripleBuffer;
+
+const C8_Display* c8_triple_buffer_acquire(C8_TripleBuffer*);
+void              c8_triple_buffer_init(C8_TripleBuffer*);
+void              c8_triple_buffer_publish(C8_TripleBuffer*, const C8_Display*);
+int               c8_triple_buffer_take_key(C8_TripleBuffer*);
+int               c8_render_loop(C8*, C8_TripleBuffer*);
+
+#endif
@@ -8,6 +8,9 @@
 #ifndef C8_UTIL_H
 #define C8_UTIL_H
 
+#include <stdint.h>
+
+void  c8_expand_row(const uint8_t*, int, uint32_t, uint32_t, uint32_t*, int);
 int   c8_hex_to_int(char);
 int   c8_parse_int(const char*);
 int   c8_to_upper(char*);
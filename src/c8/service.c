@@ -0,0 +1,236 @@
+/**
+ * @file c8/service.c
+ *
+ * Event loop embedding.
+ *
+ * Instead of sleeping between instructions, a serviced `C8` runs whole
+ * frames when their deadline passes, the way `c8_run_frame` callers do. A
+ * `timerfd` on the `CLOCK_MONOTONIC` deadline of the next frame and an
+ * `eventfd` for wakeups are gathered in one `epoll` instance, so a host
+ * only watches a single descriptor per instance and no thread ever waits
+ * on its own.
+ */
+
+#include "service.h"
+
+#include "common.h"
+
+#include "private/backend.h"
+#include "private/exception.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+C8_STATIC int    c8_service_arm(C8_Service*, double);
+C8_STATIC void   c8_service_drain(int);
+C8_STATIC double c8_service_period(const C8*);
+
+/**
+ * @brief Run the work of `service` that is due
+ *
+ * Polls the backend once, runs every frame whose deadline has passed (at
+ * most `C8_SERVICE_MAX_FRAMES`, the rest of a longer backlog is dropped),
+ * renders the last one and arms the timer for the next deadline. When
+ * uncapped, `c8->frameSkip` frames are run and rendered once, and the
+ * timer is left expired so that the host comes back after serving its other
+ * descriptors. Once `c8->running` is 0 the timer is disarmed, until it is
+ * set again and `c8_service_wake` is called.
+ *
+ * @param service `C8_Service` whose descriptor is readable
+ *
+ * @return 0 if success, exception code on failure
+ */
+int c8_service(C8_Service* service) {
+    C8*          c8      = service->c8;
+    C8_Backend*  backend = C8_BACKEND(c8);
+    const double now     = c8_input_time();
+    const double period  = c8_service_period(c8);
+    int          frames  = 0;
+    int          ret;
+    int          t;
+
+    c8_service_drain(service->timerFd);
+    c8_service_drain(service->eventFd);
+
+    if (!c8->running) {
+        return c8_service_arm(service, 0.0);
+    }
+
+    t = backend->tick(backend, &c8->keys);
+    if (t == -2) {
+        c8->running = 0;
+        return c8_service_arm(service, 0.0);
+    }
+    if (c8->waitingForKey && t >= 0) {
+        c8->V[c8->VK]     = t;
+        c8->waitingForKey = 0;
+    }
+
+    if (C8_UNCAPPED(c8)) {
+        int frameSkip = c8->frameSkip > 0 ? c8->frameSkip : C8_FRAME_SKIP;
+
+        for (; frames < frameSkip && c8->running; frames++) {
+            c8->frameTime = now;
+            if ((ret = c8_run_frame(c8)) < 0) {
+                return ret;
+            }
+        }
+        service->deadline = now;
+    } else {
+        /* A frame runs once it is over, so that its input has arrived */
+        while (service->deadline <= now && frames < C8_SERVICE_MAX_FRAMES && c8->running) {
+            c8->frameTime = service->deadline - period;
+            if ((ret = c8_run_frame(c8)) < 0) {
+                return ret;
+            }
+            service->deadline += period;
+            frames++;
+        }
+        if (service->deadline <= now) {
+            service->deadline = now + period;
+        }
+    }
+
+    if (frames > 0 && backend->render(backend, &c8->display, c8->colors) < 0) {
+        C8_HOOK(c8, C8_HOOK_EXCEPTION, C8_GRAPHICS_EXCEPTION);
+        return C8_GRAPHICS_EXCEPTION;
+    }
+    return c8_service_arm(service, c8->running ? service->deadline : 0.0);
+}
+
+/**
+ * @brief Close the descriptors of `service` and free it
+ *
+ * `service->c8` is left as it is.
+ *
+ * @param service `C8_Service` to close
+ */
+void c8_service_close(C8_Service* service) {
+    if (service->fd >= 0) {
+        close(service->fd);
+    }
+    if (service->timerFd >= 0) {
+        close(service->timerFd);
+    }
+    if (service->eventFd >= 0) {
+        close(service->eventFd);
+    }
+    free(service);
+}
+
+/**
+ * @brief Start running `c8` from a host event loop
+ *
+ * Sets `c8->running`. The first frame is due one frame from now, or at once
+ * if `c8` is uncapped.
+ *
+ * @param c8 `C8` to run
+ *
+ * @return the new `C8_Service`, whose `fd` the host must poll for input
+ * (`EPOLLIN`), or NULL on failure
+ */
+C8_Service* c8_service_open(C8* c8) {
+    struct epoll_event ev = { .events = EPOLLIN };
+    C8_Service*        service;
+    double             now;
+
+    if (c8_validate(c8) != 0) {
+        return NULL;
+    }
+
+    if (!(service = calloc(1, sizeof(C8_Service)))) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to allocate event loop state");
+        return NULL;
+    }
+
+    service->c8      = c8;
+    service->fd      = epoll_create1(EPOLL_CLOEXEC);
+    service->timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    service->eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (service->fd < 0 || service->timerFd < 0 || service->eventFd < 0
+        || epoll_ctl(service->fd, EPOLL_CTL_ADD, service->timerFd, &ev) != 0
+        || epoll_ctl(service->fd, EPOLL_CTL_ADD, service->eventFd, &ev) != 0) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to create event loop descriptors");
+        c8_service_close(service);
+        return NULL;
+    }
+
+    now               = c8_input_time();
+    service->deadline = C8_UNCAPPED(c8) ? now : now + c8_service_period(c8);
+    c8->running       = 1;
+    if (c8_service_arm(service, service->deadline) != 0) {
+        c8_service_close(service);
+        return NULL;
+    }
+    return service;
+}
+
+/**
+ * @brief Make the descriptor of `service` readable now
+ *
+ * May be called from any thread, for example after `service->c8` was
+ * started again or its speed was changed, so that the next `c8_service`
+ * call picks it up without waiting for the timer.
+ *
+ * @param service `C8_Service` to wake
+ *
+ * @return 0 if success, C8_IO_EXCEPTION on failure
+ */
+int c8_service_wake(C8_Service* service) {
+    uint64_t one = 1;
+
+    if (write(service->eventFd, &one, sizeof(one)) != sizeof(one)) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to wake event loop");
+        return C8_IO_EXCEPTION;
+    }
+    return 0;
+}
+
+/**
+ * @brief Arm the timer of `service` for `deadline`
+ *
+ * @param service `C8_Service` to arm
+ * @param deadline `c8_input_time` at which to expire, or 0 to disarm
+ *
+ * @return 0 if success, C8_IO_EXCEPTION on failure
+ */
+C8_STATIC int c8_service_arm(C8_Service* service, double deadline) {
+    struct itimerspec its = { { 0, 0 }, { 0, 0 } };
+
+    if (deadline > 0.0) {
+        its.it_value.tv_sec  = (time_t) deadline;
+        its.it_value.tv_nsec = (long) ((deadline - its.it_value.tv_sec) * 1e9);
+    }
+    if (timerfd_settime(service->timerFd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to arm frame timer");
+        return C8_IO_EXCEPTION;
+    }
+    return 0;
+}
+
+/**
+ * @brief Clear a readable `timerfd` or `eventfd`
+ *
+ * @param fd non-blocking descriptor to read
+ */
+C8_STATIC void c8_service_drain(int fd) {
+    uint64_t count;
+
+    while (read(fd, &count, sizeof(count)) > 0) {
+    }
+}
+
+/**
+ * @brief Get the duration of one frame of `c8` at its speed
+ *
+ * @param c8 `C8` to look at
+ *
+ * @return seconds per frame
+ */
+C8_STATIC double c8_service_period(const C8* c8) {
+    return 100.0 / 60.0 / (c8->speed > 0 ? c8->speed : 100);
+}
@@ -0,0 +1,43 @@
+/**
+ * @file c8/service.h
+ *
+ * Event loop embedding (Linux): a `C8` run from a host's own `epoll` (or
+ * `poll`) loop instead of `c8_simulate`, so many instances can share a few
+ * threads.
+ */
+
+#ifndef C8_SERVICE_H
+#define C8_SERVICE_H
+
+#include "chip8.h"
+
+/**
+ * @brief Most frames a `c8_service` call catches up on before dropping the
+ * rest of the backlog (0.1 s at normal speed).
+ */
+#define C8_SERVICE_MAX_FRAMES 6
+
+/**
+  * @struct C8_Service
+  * @brief A `C8` driven by a host event loop
+  *
+  * `fd` becomes readable when the next frame is due or `c8_service_wake`
+  * was called. The host then calls `c8_service`, which runs the frames that
+  * are due, renders the last one and rearms the timer. Frames run with
+  * `c8_run_frame`, so key events pushed to `c8->input` with `c8_input_time`
+  * stamps are applied at the instruction they fall on.
+  */
+typedef struct {
+    C8*    c8; //!< `C8` being run
+    int    fd; //!< `epoll` instance over `timerFd` and `eventFd`, for the host to poll
+    int    timerFd; //!< `timerfd` armed for the end of the next frame
+    int    eventFd; //!< `eventfd` written by `c8_service_wake`
+    double deadline; //!< `c8_input_time` at which the next frame ends
+} C8_Service;
+
+int         c8_service(C8_Service*);
+void        c8_service_close(C8_Service*);
+C8_Service* c8_service_open(C8*);
+int         c8_service_wake(C8_Service*);
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * @file c8/shm.c
+ *
+ * Export of the display and key state through POSIX shared memory.
+ *
+ * The emulator publishes each frame with a sequence lock: `seq` is made odd,
+ * the frame is written, and `seq` is made even again. Readers copy the frame
+ * and retry if `seq` was odd or changed meanwhile, so neither side ever
+ * blocks the other. Keys go the other way as a bitmask that viewers store
+ * atomically.
+ */
+
+#include "shm.h"
+
+#include "common.h"
+
+#include "private/backend.h"
+#include "private/exception.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+C8_STATIC int c8_shm_backend_render(C8_Backend*, C8_Display*, int*);
+C8_STATIC int c8_shm_backend_tick(C8_Backend*, uint32_t*);
+
+/**
+ * @brief Publish every frame rendered by `c8` to `shm` and take keys from it
+ *
+ * The current backend of `c8` keeps working: it is wrapped by one that
+ * publishes each frame before passing it on, and that merges the keys held
+ * in the segment into the keys of the wrapped backend. Backend-specific
+ * state must be set up before calling this. `shm` must still be closed with
+ * `c8_shm_close` after `c8` is deinitialized.
+ *
+ * @param c8 `C8` to export
+ * @param shm segment opened with `C8_SHM_CREATE`
+ *
+ * @return 0 if success, C8_GRAPHICS_EXCEPTION on failure
+ */
+int c8_shm_attach(C8* c8, C8_Shm* shm) {
+    const C8_Backend wrapper = {
+        .name   = "shm",
+        .render = c8_shm_backend_render,
+        .tick   = c8_shm_backend_tick,
+    };
+    return c8_wrap_backend(c8, &wrapper, shm);
+}
+
+/**
+ * @brief Unmap `shm` and free it
+ *
+ * The segment is removed if `shm` created it.
+ *
+ * @param shm `C8_Shm` to close
+ */
+void c8_shm_close(C8_Shm* shm) {
+    munmap(shm->seg, sizeof(C8_ShmSegment));
+    if (shm->owner) {
+        shm_unlink(shm->name);
+    }
+    free(shm->name);
+    free(shm);
+}
+
+/**
+ * @brief Get the keys held by viewers
+ *
+ * @param shm `C8_Shm` to read
+ *
+ * @return bitmask of held keys, bit N is key N
+ */
+uint32_t c8_shm_keys(const C8_Shm* shm) {
+    return __atomic_load_n(&shm->seg->keys, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Map the segment called `name`
+ *
+ * @param name segment name, starting with '/'
+ * @param flags `C8_SHM_CREATE` to create (or reset) the segment, 0 to open
+ * one created by another process
+ *
+ * @return the mapped segment, or NULL on failure
+ */
+C8_Shm* c8_shm_open(const char* name, int flags) {
+    int     create = flags & C8_SHM_CREATE;
+    C8_Shm* shm    = calloc(1, sizeof(C8_Shm));
+    int     fd;
+
+    if (!shm || !(shm->name = strdup(name))) {
+        free(shm);
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to allocate shared memory %s", name);
+        return NULL;
+    }
+
+    fd = shm_open(name, create ? O_CREAT | O_RDWR : O_RDWR, 0600);
+    if (fd < 0) {
+        free(shm->name);
+        free(shm);
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Could not open shared memory %s", name);
+        return NULL;
+    }
+
+    struct stat st;
+    if ((create && ftruncate(fd, sizeof(C8_ShmSegment)) != 0)
+        || (!create && (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(C8_ShmSegment)))) {
+        close(fd);
+        free(shm->name);
+        free(shm);
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Shared memory %s has the wrong size", name);
+        return NULL;
+    }
+
+    shm->seg = mmap(NULL, sizeof(C8_ShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm->seg == MAP_FAILED) {
+        free(shm->name);
+        free(shm);
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Could not map shared memory %s", name);
+        return NULL;
+    }
+
+    if (create) {
+        memset(shm->seg, 0, sizeof(C8_ShmSegment));
+        shm->seg->version = C8_SHM_VERSION;
+        __atomic_store_n(&shm->seg->magic, C8_SHM_MAGIC, __ATOMIC_RELEASE);
+        shm->owner = 1;
+    } else if (__atomic_load_n(&shm->seg->magic, __ATOMIC_ACQUIRE) != C8_SHM_MAGIC
+               || shm->seg->version != C8_SHM_VERSION) {
+        munmap(shm->seg, sizeof(C8_ShmSegment));
+        free(shm->name);
+        free(shm);
+        C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION, "Shared memory %s is not a libc8 display", name);
+        return NULL;
+    }
+    return shm;
+}
+
+/**
+ * @brief Publish `display` to the segment
+ *
+ * @param shm `C8_Shm` to publish to
+ * @param display `C8_Display` to publish
+ * @param colors background and foreground colors
+ */
+void c8_shm_publish(C8_Shm* shm, const C8_Display* display, const int* colors) {
+    C8_ShmSegment* seg = shm->seg;
+    uint32_t       seq = __atomic_load_n(&seg->seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&seg->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    c8_display_pack(display, seg->p);
+    seg->mode      = display->mode;
+    seg->colors[0] = colors[0];
+    seg->colors[1] = colors[1];
+    seg->frame++;
+
+    __atomic_store_n(&seg->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Copy the latest frame out of the segment
+ *
+ * @param shm `C8_Shm` to read
+ * @param display where to store the frame
+ * @param colors where to store the background and foreground colors
+ *
+ * @return 0 if success, C8_INVALID_STATE_EXCEPTION if no consistent frame
+ * could be read in `C8_SHM_READ_RETRIES` tries
+ */
+int c8_shm_read(const C8_Shm* shm, C8_Display* display, int* colors) {
+    const C8_ShmSegment* seg = shm->seg;
+    uint8_t              p[C8_PACKED_DISPLAY_SIZE];
+    uint32_t             mode;
+    int32_t              c[2];
+
+    for (int i = 0; i < C8_SHM_READ_RETRIES; i++) {
+        uint32_t seq = __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+
+        memcpy(p, seg->p, sizeof(p));
+        mode = seg->mode;
+        c[0] = seg->colors[0];
+        c[1] = seg->colors[1];
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&seg->seq, __ATOMIC_RELAXED) == seq) {
+            c8_display_unpack(display, p, mode);
+            colors[0] = c[0];
+            colors[1] = c[1];
+            return 0;
+        }
+    }
+
+    C8_EXCEPTION(C8_INVALID_STATE_EXCEPTION, "Could not read a consistent frame");
+    return C8_INVALID_STATE_EXCEPTION;
+}
+
+/**
+ * @brief Set the keys held by this viewer
+ *
+ * @param shm `C8_Shm` to write
+ * @param keys bitmask of held keys, bit N is key N
+ */
+void c8_shm_set_keys(C8_Shm* shm, uint32_t keys) {
+    __atomic_store_n(&shm->seg->keys, keys, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publish `display` and render it with the wrapped backend.
+ *
+ * @param backend the backend instance
+ * @param display `C8_Display` to render
+ * @param colors colors to render
+ * @return the return value of the wrapped backend's `render`
+ */
+C8_STATIC int c8_shm_backend_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    C8_BackendWrapper* ctx   = (C8_BackendWrapper*) backend->ctx;
+    C8_Backend*        inner = c8_wrapped_backend(backend);
+
+    c8_shm_publish((C8_Shm*) ctx->data, display, colors);
+    return inner->render(inner, display, colors);
+}
+
+/**
+ * @brief Poll the wrapped backend, then apply key changes from the segment.
+ *
+ * At most one key release is reported per call; further releases are
+ * applied on the next calls.
+ *
+ * @param backend the backend instance
+ * @param keys key state bitmask
+ *
+ * @return -2 if quitting, -1 if no key was released, else returns value
+ * of key released.
+ */
+C8_STATIC int c8_shm_backend_tick(C8_Backend* backend, uint32_t* keys) {
+    C8_BackendWrapper* ctx   = (C8_BackendWrapper*) backend->ctx;
+    C8_Shm*            shm   = (C8_Shm*) ctx->data;
+    C8_Backend*        inner = c8_wrapped_backend(backend);
+    int                ret   = inner->tick(inner, keys);
+    uint32_t           held  = c8_shm_keys(shm);
+
+    if (ret == -2 || __atomic_load_n(&shm->seg->quit, __ATOMIC_ACQUIRE)) {
+        return -2;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        uint32_t bit = 1u << i;
+        if (!((held ^ shm->keys) & bit)) {
+            continue;
+        }
+
+        if (!(held & bit)) {
+            if (ret >= 0) {
+                continue;
+            }
+            ret = i;
+        }
+        c8_input_set_key(keys, i, (held & bit) != 0);
+        shm->keys ^= bit;
+    }
+    return ret;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file c8/shm.h
+ *
+ * Export of the display and key state through POSIX shared memory, so other
+ * processes can watch and control an instance without copies or sockets.
+ */
+
+#ifndef C8_SHM_H
+#define C8_SHM_H
+
+#include "chip8.h"
+#include "graphics.h"
+
+#include <stdint.h>
+
+/**
+ * @brief `C8_ShmSegment.magic` of an initialized segment ("C8FB").
+ */
+#define C8_SHM_MAGIC 0x43384642
+
+/**
+ * @brief Layout version of `C8_ShmSegment`.
+ */
+#define C8_SHM_VERSION 1
+
+/**
+ * @brief Create the segment (emulator side) instead of opening an existing one (viewer side).
+ */
+#define C8_SHM_CREATE 0x1
+
+/**
+ * @brief Number of times `c8_shm_read` retries while a frame is being written.
+ */
+#define C8_SHM_READ_RETRIES 1000
+
+/**
+  * @struct C8_ShmSegment
+  * @brief Layout of the shared memory segment
+  *
+  * The frame fields are guarded by `seq`, which is odd while a frame is
+  * being written. Read them with `c8_shm_read`. `keys` and `quit` are
+  * written by viewers.
+  */
+typedef struct {
+    uint32_t magic; //!< `C8_SHM_MAGIC`
+    uint32_t version; //!< `C8_SHM_VERSION`
+    uint32_t seq; //!< Sequence counter, odd while the frame is being written
+    uint32_t frame; //!< Number of frames published
+    int32_t  colors[2]; //!< Background and foreground colors
+    uint32_t mode; //!< Display mode of `p`
+    uint32_t keys; //!< Held keys, bit N is key N (written by viewers)
+    uint32_t quit; //!< Set to non-zero by a viewer to stop the emulator
+    uint32_t reserved[3]; //!< Zero
+    uint8_t  p[C8_PACKED_DISPLAY_SIZE]; //!< Pixels, packed with `c8_display_pack`
+} C8_ShmSegment;
+
+/**
+  * @struct C8_Shm
+  * @brief A mapped segment
+  */
+typedef struct {
+    C8_ShmSegment* seg; //!< The mapped segment
+    char*          name; //!< Segment name, unlinked on close if `owner`
+    int            owner; //!< 1 if the segment was created by `c8_shm_open`
+    uint32_t       keys; //!< Segment keys already applied by the `c8_shm_attach` backend
+} C8_Shm;
+
+int      c8_shm_attach(C8*, C8_Shm*);
+void     c8_shm_close(C8_Shm*);
+uint32_t c8_shm_keys(const C8_Shm*);
+C8_Shm*  c8_shm_open(const char*, int);
+void     c8_shm_publish(C8_Shm*, const C8_Display*, const int*);
+int      c8_shm_read(const C8_Shm*, C8_Display*, int*);
+void     c8_shm_set_keys(C8_Shm*, uint32_t);
+
+#endif
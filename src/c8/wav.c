@@ -0,0 +1,308 @@
+/**
+ * @file c8/wav.c
+ *
+ * Headless audio capture to WAV.
+ *
+ * Frame N covers samples `N * rate / 60` up to `(N + 1) * rate / 60`, so
+ * frames of uneven length never drift. A sound change made by the Kth
+ * instruction of a frame of C instructions takes effect K/C of the way
+ * through it, and one made when the sound timer runs out at the end of the
+ * frame. Samples up to each change are rendered as soon as it happens.
+ */
+
+#include "wav.h"
+
+#include "common.h"
+
+#include "private/backend.h"
+#include "private/exception.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Size of a WAV header with a single `fmt ` and `data` chunk.
+ */
+#define C8_WAV_HEADER_SIZE 44
+
+C8_STATIC int    c8_wav_change(C8_Backend*);
+C8_STATIC int    c8_wav_fill(C8_Wav*, size_t);
+C8_STATIC size_t c8_wav_frame_start(const C8_Wav*, unsigned);
+C8_STATIC void   c8_wav_put16(uint8_t*, unsigned);
+C8_STATIC void   c8_wav_put32(uint8_t*, uint32_t);
+C8_STATIC int    c8_wav_sound_pattern(C8_Backend*, const uint8_t*, int);
+C8_STATIC int    c8_wav_sound_play(C8_Backend*);
+C8_STATIC int    c8_wav_sound_stop(C8_Backend*);
+
+/**
+ * @brief Capture the sound of `c8` into `wav`
+ *
+ * The current backend of `c8` keeps working: it is wrapped by one that
+ * records each sound change before passing it on. `c8` must then be run
+ * with `c8_run_frame`, calling `c8_wav_end_frame` after each frame. `wav`
+ * must still be closed with `c8_wav_close` after `c8` is deinitialized.
+ *
+ * @param c8 `C8` to capture
+ * @param wav capture opened with `c8_wav_open`
+ *
+ * @return 0 if success, C8_GRAPHICS_EXCEPTION on failure
+ */
+int c8_wav_attach(C8* c8, C8_Wav* wav) {
+    const C8_Backend wrapper = {
+        .name          = "wav",
+        .sound_play    = c8_wav_sound_play,
+        .sound_stop    = c8_wav_sound_stop,
+        .sound_pattern = c8_wav_sound_pattern,
+    };
+
+    wav->c8 = c8;
+    memcpy(wav->sound.pattern, c8->pattern, C8_AUDIO_PATTERN_SIZE);
+    wav->sound.pitch      = c8->pitch;
+    wav->sound.patternSet = c8->patternSet;
+    wav->sound.on         = c8->st > 0;
+    wav->audio.state      = wav->sound;
+    return c8_wrap_backend(c8, &wrapper, wav);
+}
+
+/**
+ * @brief Free `wav`
+ *
+ * @param wav `C8_Wav` to close
+ */
+void c8_wav_close(C8_Wav* wav) {
+    free(wav->samples);
+    free(wav);
+}
+
+/**
+ * @brief Render the rest of the current frame
+ *
+ * @param wav `C8_Wav` to render
+ *
+ * @return 0 if success, C8_IO_EXCEPTION if the samples could not be stored
+ */
+int c8_wav_end_frame(C8_Wav* wav) {
+    int ret = c8_wav_fill(wav, c8_wav_frame_start(wav, wav->frameCount + 1));
+    if (ret == 0) {
+        wav->frameCount++;
+    }
+    return ret;
+}
+
+/**
+ * @brief Start an audio capture
+ *
+ * @param rate sample rate in Hz (`C8_WAV_RATE` unless the output must match
+ * something else)
+ *
+ * @return the capture, or NULL on failure
+ */
+C8_Wav* c8_wav_open(int rate) {
+    C8_Wav* wav;
+
+    if (rate < C8_WAV_FPS) {
+        C8_EXCEPTION(C8_INVALID_PARAMETER_EXCEPTION, "Invalid sample rate: %d", rate);
+        return NULL;
+    }
+
+    wav = calloc(1, sizeof(C8_Wav));
+    if (!wav) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to allocate audio capture");
+        return NULL;
+    }
+
+    c8_audio_init(&wav->audio, rate);
+    wav->sound.pitch = C8_AUDIO_DEFAULT_PITCH;
+    return wav;
+}
+
+/**
+ * @brief Write the captured samples to `path` as a mono 16-bit PCM WAV file
+ *
+ * @param wav `C8_Wav` to write
+ * @param path file to write
+ *
+ * @return 0 if success, C8_IO_EXCEPTION on failure
+ */
+int c8_wav_write(const C8_Wav* wav, const char* path) {
+    uint8_t  header[C8_WAV_HEADER_SIZE];
+    uint8_t  buf[512];
+    uint32_t size = (uint32_t) (wav->sampleCount * sizeof(int16_t));
+    FILE*    f    = fopen(path, "wb");
+    int      ok;
+
+    if (!f) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Could not open %s", path);
+        return C8_IO_EXCEPTION;
+    }
+
+    memcpy(header, "RIFF", 4);
+    c8_wav_put32(header + 4, C8_WAV_HEADER_SIZE - 8 + size);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    c8_wav_put32(header + 16, 16);
+    c8_wav_put16(header + 20, 1); /* PCM */
+    c8_wav_put16(header + 22, 1); /* mono */
+    c8_wav_put32(header + 24, wav->audio.rate);
+    c8_wav_put32(header + 28, wav->audio.rate * sizeof(int16_t));
+    c8_wav_put16(header + 32, sizeof(int16_t));
+    c8_wav_put16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    c8_wav_put32(header + 40, size);
+    ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+
+    /* Samples are little-endian whatever the host is */
+    for (size_t i = 0; ok && i < wav->sampleCount; i += sizeof(buf) / 2) {
+        size_t n = wav->sampleCount - i < sizeof(buf) / 2 ? wav->sampleCount - i : sizeof(buf) / 2;
+        for (size_t j = 0; j < n; j++) {
+            c8_wav_put16(buf + j * 2, (uint16_t) wav->samples[i + j]);
+        }
+        ok = fwrite(buf, 2, n, f) == n;
+    }
+
+    if (fclose(f) != 0 || !ok) {
+        C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to write %s", path);
+        return C8_IO_EXCEPTION;
+    }
+    return 0;
+}
+
+/**
+ * @brief Render up to the current instruction, then apply `wav->sound`
+ *
+ * @param backend the wrapper instance
+ *
+ * @return 0 if success, C8_IO_EXCEPTION if the samples could not be stored
+ */
+C8_STATIC int c8_wav_change(C8_Backend* backend) {
+    C8_Wav* wav   = (C8_Wav*) ((C8_BackendWrapper*) backend->ctx)->data;
+    size_t  start = c8_wav_frame_start(wav, wav->frameCount);
+    size_t  len   = c8_wav_frame_start(wav, wav->frameCount + 1) - start;
+    int     count = c8_frame_cycles(wav->c8);
+    int     step  = wav->c8->frameStep < count ? wav->c8->frameStep : count;
+    int     ret   = c8_wav_fill(wav, start + len * step / count);
+
+    /* Only this thread renders, so there is no need to go through the queue */
+    wav->audio.state = wav->sound;
+    return ret;
+}
+
+/**
+ * @brief Render samples up to (not including) sample `end`
+ *
+ * @param wav `C8_Wav` to render
+ * @param end index of the first sample not to render
+ *
+ * @return 0 if success, C8_IO_EXCEPTION if the samples could not be stored
+ */
+C8_STATIC int c8_wav_fill(C8_Wav* wav, size_t end) {
+    if (end <= wav->sampleCount) {
+        return 0;
+    }
+
+    if (end > wav->capacity) {
+        size_t   capacity = wav->capacity ? wav->capacity : (size_t) wav->audio.rate;
+        int16_t* samples;
+
+        while (capacity < end) {
+            capacity *= 2;
+        }
+        if (!(samples = realloc(wav->samples, capacity * sizeof(int16_t)))) {
+            C8_EXCEPTION(C8_IO_EXCEPTION, "Failed to allocate audio capture");
+            return C8_IO_EXCEPTION;
+        }
+        wav->samples  = samples;
+        wav->capacity = capacity;
+    }
+
+    /* Nothing is ever queued here, the state is set directly, so the time is unused */
+    c8_audio_render(&wav->audio, wav->samples + wav->sampleCount, end - wav->sampleCount, 0);
+    wav->sampleCount = end;
+    return 0;
+}
+
+/**
+ * @brief Get the index of the first sample of frame `frame`
+ *
+ * @param wav `C8_Wav` to look at
+ * @param frame frame number
+ *
+ * @return the sample index
+ */
+C8_STATIC size_t c8_wav_frame_start(const C8_Wav* wav, unsigned frame) {
+    return (size_t) ((uint64_t) frame * wav->audio.rate / C8_WAV_FPS);
+}
+
+/**
+ * @brief Store `v` as 2 little-endian bytes
+ *
+ * @param p where to store `v`
+ * @param v value to store
+ */
+C8_STATIC void c8_wav_put16(uint8_t* p, unsigned v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+/**
+ * @brief Store `v` as 4 little-endian bytes
+ *
+ * @param p where to store `v`
+ * @param v value to store
+ */
+C8_STATIC void c8_wav_put32(uint8_t* p, uint32_t v) {
+    c8_wav_put16(p, v & 0xFFFF);
+    c8_wav_put16(p + 2, v >> 16);
+}
+
+/**
+ * @brief Record a new XO-CHIP pattern and pitch, then pass them on
+ *
+ * @param backend the wrapper instance
+ * @param pattern `C8_AUDIO_PATTERN_SIZE` bytes of pattern
+ * @param pitch playback pitch
+ *
+ * @return the return value of the wrapped backend's `sound_pattern`
+ */
+C8_STATIC int c8_wav_sound_pattern(C8_Backend* backend, const uint8_t* pattern, int pitch) {
+    C8_Wav*     wav   = (C8_Wav*) ((C8_BackendWrapper*) backend->ctx)->data;
+    C8_Backend* inner = c8_wrapped_backend(backend);
+
+    memcpy(wav->sound.pattern, pattern, C8_AUDIO_PATTERN_SIZE);
+    wav->sound.pitch      = pitch;
+    wav->sound.patternSet = 1;
+    c8_wav_change(backend);
+    return inner->sound_pattern(inner, pattern, pitch);
+}
+
+/**
+ * @brief Record the start of the tone, then pass it on
+ *
+ * @param backend the wrapper instance
+ *
+ * @return the return value of the wrapped backend's `sound_play`
+ */
+C8_STATIC int c8_wav_sound_play(C8_Backend* backend) {
+    C8_Wav*     wav   = (C8_Wav*) ((C8_BackendWrapper*) backend->ctx)->data;
+    C8_Backend* inner = c8_wrapped_backend(backend);
+
+    wav->sound.on = 1;
+    c8_wav_change(backend);
+    return inner->sound_play(inner);
+}
+
+/**
+ * @brief Record the end of the tone, then pass it on
+ *
+ * @param backend the wrapper instance
+ *
+ * @return the return value of the wrapped backend's `sound_stop`
+ */
+C8_STATIC int c8_wav_sound_stop(C8_Backend* backend) {
+    C8_Wav*     wav   = (C8_Wav*) ((C8_BackendWrapper*) backend->ctx)->data;
+    C8_Backend* inner = c8_wrapped_backend(backend);
+
+    wav->sound.on = 0;
+    c8_wav_change(backend);
+    return inner->sound_stop(inner);
+}
@@ -0,0 +1,52 @@
+/**
+ * @file c8/wav.h
+ *
+ * Headless audio capture: the buzzer and XO-CHIP patterns of a `C8` run
+ * with `c8_run_frame`, rendered to 16-bit PCM and written as a WAV file.
+ */
+
+#ifndef C8_WAV_H
+#define C8_WAV_H
+
+#include "audio.h"
+#include "chip8.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Default sample rate of captured audio, in Hz.
+ */
+#define C8_WAV_RATE 44100
+
+/**
+ * @brief Frame rate `c8_wav_end_frame` assumes.
+ */
+#define C8_WAV_FPS 60
+
+/**
+  * @struct C8_Wav
+  * @brief Audio being captured
+  *
+  * Sound changes are placed at the position of the instruction that made
+  * them within its frame (`c8->frameStep` out of `c8_frame_cycles`),
+  * so the output only depends on the program and the sample rate, never on
+  * how fast the host runs it.
+  */
+typedef struct {
+    C8*           c8; //!< `C8` being captured (set by `c8_wav_attach`)
+    C8_Audio      audio; //!< Tone generator
+    C8_AudioState sound; //!< Sound as of the last change
+    int16_t*      samples; //!< Captured samples
+    size_t        sampleCount; //!< Number of samples in `samples`
+    size_t        capacity; //!< Number of samples `samples` can hold
+    unsigned      frameCount; //!< Number of frames ended with `c8_wav_end_frame`
+} C8_Wav;
+
+int     c8_wav_attach(C8*, C8_Wav*);
+void    c8_wav_close(C8_Wav*);
+int     c8_wav_end_frame(C8_Wav*);
+C8_Wav* c8_wav_open(int);
+int     c8_wav_write(const C8_Wav*, const char*);
+
+#endif
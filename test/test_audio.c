@@ -0,0 +1,84 @@
+#include "c8/audio.h"
+
+#include "unity.h"
+
+#include <string.h>
+
+#define RATE 48000
+
+C8_Audio      audio;
+C8_AudioState state;
+int16_t       out[256];
+
+void setUp(void) {
+    c8_audio_init(&audio, RATE);
+    memset(&state, 0, sizeof(C8_AudioState));
+    state.pitch = C8_AUDIO_DEFAULT_PITCH;
+}
+
+void tearDown(void) {}
+
+void test_c8_audio_init_PitchSteps(void) {
+    /* 4000 Hz at pitch 64, one octave per 48 steps */
+    TEST_ASSERT_EQUAL_UINT32((4000ULL << 25) / RATE, audio.steps[64]);
+    TEST_ASSERT_EQUAL_UINT32((8000ULL << 25) / RATE, audio.steps[112]);
+    TEST_ASSERT_EQUAL_UINT32((2000ULL << 25) / RATE, audio.steps[16]);
+    /* 4000 * 2^(-64/48) = 1587.4 Hz */
+    TEST_ASSERT_EQUAL_UINT32(1109674, audio.steps[0]);
+    TEST_ASSERT_TRUE(audio.steps[255] > audio.steps[254]);
+}
+
+void test_c8_audio_render_WhileOff(void) {
+    memset(out, 0x55, sizeof(out));
+    c8_audio_render(&audio, out, 256, 0);
+    for (int i = 0; i < 256; i++) {
+        TEST_ASSERT_EQUAL_INT(0, out[i]);
+    }
+}
+
+void test_c8_audio_render_PlaysPattern(void) {
+    /* At pitch 64 and 4000 Hz, every sample is one bit of the pattern */
+    c8_audio_init(&audio, 4000);
+    state.on         = 1;
+    state.patternSet = 1;
+    state.pattern[0] = 0xA0;
+    TEST_ASSERT_EQUAL_INT(0, c8_audio_push(&audio, &state, 0));
+    c8_audio_render(&audio, out, 4, 1);
+    TEST_ASSERT_EQUAL_INT(C8_AUDIO_VOLUME, out[0]);
+    TEST_ASSERT_EQUAL_INT(-C8_AUDIO_VOLUME, out[1]);
+    TEST_ASSERT_EQUAL_INT(C8_AUDIO_VOLUME, out[2]);
+    TEST_ASSERT_EQUAL_INT(-C8_AUDIO_VOLUME, out[3]);
+}
+
+void test_c8_audio_push_TakesLatestState(void) {
+    state.on = 1;
+    c8_audio_push(&audio, &state, 0);
+    state.on = 0;
+    c8_audio_push(&audio, &state, 0);
+    c8_audio_render(&audio, out, 16, 1);
+    TEST_ASSERT_EQUAL_INT(0, audio.state.on);
+    TEST_ASSERT_EQUAL_UINT32(audio.head, audio.tail);
+    TEST_ASSERT_EQUAL_INT(0, out[0]);
+}
+
+void test_c8_audio_render_AppliesStatesAtTheirOffsets(void) {
+    /* A beep over the middle half of the buffer, which ends at 256 samples */
+    state.on = 1;
+    c8_audio_push(&audio, &state, 64.0 / RATE);
+    state.on = 0;
+    c8_audio_push(&audio, &state, 192.0 / RATE);
+    c8_audio_render(&audio, out, 256, 256.0 / RATE);
+    for (int i = 0; i < 256; i++) {
+        TEST_ASSERT_EQUAL_INT(i >= 64 && i < 192, out[i] != 0);
+    }
+    TEST_ASSERT_EQUAL_INT(0, audio.state.on);
+}
+
+void test_c8_audio_push_WhereQueueIsFull(void) {
+    for (int i = 0; i < C8_AUDIO_QUEUE_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_audio_push(&audio, &state, 0));
+    }
+    TEST_ASSERT_EQUAL_INT(1, c8_audio_push(&audio, &state, 0));
+    c8_audio_render(&audio, out, 1, 0);
+    TEST_ASSERT_EQUAL_INT(0, c8_audio_push(&audio, &state, 0));
+}
@@ -0,0 +1,109 @@
+#include "c8/capture.h"
+#include "c8/chip8.h"
+#include "c8/graphics.h"
+#include "c8/offscreen.h"
+#include "c8/private/exception.h"
+
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define CAPTURE_PATH "capture_test.out"
+#define Y4M_HEADER   "YUV4MPEG2 W128 H64 F60:1 Ip A1:1 C444 XCOLORRANGE=FULL\n"
+#define Y4M_FRAME    (6 + C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT * 3)
+
+extern void c8_capture_unpack(const C8_CaptureFrame*, uint8_t*);
+
+C8 c8;
+
+static long file_size(const char* path) {
+    FILE* f = fopen(path, "rb");
+    long  size;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+void setUp(void) {
+    memset(&c8, 0, sizeof(C8));
+    c8.colors[1] = 0xFFFFFF;
+}
+
+void tearDown(void) {
+    remove(CAPTURE_PATH);
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_capture_open_WithInvalidFormat(void) {
+    TEST_ASSERT_NULL(c8_capture_open(CAPTURE_PATH, 2));
+    TEST_ASSERT_NULL(c8_capture_open("non_existent/capture.gif", C8_CAPTURE_GIF));
+}
+
+void test_c8_capture_close_WritesGif(void) {
+    uint8_t     header[6];
+    C8_Capture* cap = c8_capture_open(CAPTURE_PATH, C8_CAPTURE_GIF);
+    FILE*       f;
+
+    TEST_ASSERT_NOT_NULL(cap);
+    for (int i = 0; i < 10; i++) {
+        c8.display.p[i] = 1;
+        TEST_ASSERT_EQUAL_INT(0, c8_capture_frame(cap, &c8.display, c8.colors));
+    }
+    TEST_ASSERT_EQUAL_INT(10, cap->frameCount);
+    TEST_ASSERT_EQUAL_INT(0, c8_capture_close(cap));
+
+    f = fopen(CAPTURE_PATH, "rb");
+    TEST_ASSERT_EQUAL_INT(6, fread(header, 1, 6, f));
+    TEST_ASSERT_EQUAL_MEMORY("GIF89a", header, 6);
+    fseek(f, -1, SEEK_END);
+    TEST_ASSERT_EQUAL_INT(0x3B, fgetc(f));
+    fclose(f);
+}
+
+void test_c8_capture_close_WritesY4m(void) {
+    C8_Capture* cap = c8_capture_open(CAPTURE_PATH, C8_CAPTURE_Y4M);
+
+    TEST_ASSERT_NOT_NULL(cap);
+    c8_capture_frame(cap, &c8.display, c8.colors);
+    cap->frameCount++; /* As if a frame was dropped */
+    c8_capture_frame(cap, &c8.display, c8.colors);
+    TEST_ASSERT_EQUAL_INT(0, c8_capture_close(cap));
+
+    TEST_ASSERT_EQUAL_INT(strlen(Y4M_HEADER) + 3 * Y4M_FRAME, file_size(CAPTURE_PATH));
+}
+
+void test_c8_capture_attach_FeedsCaptureAndBackend(void) {
+    C8_Capture*   cap = c8_capture_open(CAPTURE_PATH, C8_CAPTURE_Y4M);
+    C8_Offscreen* off;
+
+    TEST_ASSERT_EQUAL_INT(0, c8_init_graphics(&c8, "offscreen", 0));
+    off = c8_offscreen(&c8);
+    TEST_ASSERT_EQUAL_INT(0, c8_capture_attach(&c8, cap));
+    TEST_ASSERT_EQUAL_STRING("capture", c8.backend->name);
+
+    TEST_ASSERT_EQUAL_INT(0, c8.backend->render(c8.backend, &c8.display, c8.colors));
+    TEST_ASSERT_EQUAL_INT(-1, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_INT(1, off->frameCount);
+    TEST_ASSERT_EQUAL_INT(1, cap->frameCount);
+
+    TEST_ASSERT_EQUAL_INT(0, c8_deinit_graphics(&c8));
+    TEST_ASSERT_EQUAL_INT(0, c8_capture_close(cap));
+}
+
+void test_c8_capture_unpack_WithLowDisplayMode(void) {
+    C8_CaptureFrame frame;
+    uint8_t         out[C8_HIGH_DISPLAY_WIDTH * C8_HIGH_DISPLAY_HEIGHT];
+
+    memset(&frame, 0, sizeof(frame));
+    frame.mode = C8_DISPLAYMODE_LOW;
+    frame.p[8] = 0x80; /* (0, 1) */
+    c8_capture_unpack(&frame, out);
+
+    TEST_ASSERT_EQUAL_INT(0, out[0]);
+    TEST_ASSERT_EQUAL_INT(1, out[2 * C8_HIGH_DISPLAY_WIDTH]);
+    TEST_ASSERT_EQUAL_INT(1, out[2 * C8_HIGH_DISPLAY_WIDTH + 1]);
+    TEST_ASSERT_EQUAL_INT(1, out[3 * C8_HIGH_DISPLAY_WIDTH]);
+    TEST_ASSERT_EQUAL_INT(0, out[3 * C8_HIGH_DISPLAY_WIDTH + 2]);
+}
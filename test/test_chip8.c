@@ -1,5 +1,7 @@
 #include "c8/chip8.h"
+#include "c8/graphics.h"
 #include "c8/private/exception.h"
+#include "c8/private/instruction.h"
 #include "util.c"
 
 #include "unity.h"
@@ -9,6 +11,60 @@
 
 C8   c8;
 char buf[1024];
+int  pollCount;
+int  polledI[3];
+int  renderCount;
+int  renderedI[3];
+
+int hookCount[C8_HOOK_COUNT];
+int hookArg[C8_HOOK_COUNT];
+
+static void test_hook(void* data, int event, int arg) {
+    ((int*) data)[event]++;
+    hookArg[event] = arg;
+}
+
+static void set_hooks(void) {
+    memset(hookCount, 0, sizeof(hookCount));
+    for (int event = 0; event < C8_HOOK_COUNT; event++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_set_hook(&c8, event, test_hook, hookCount));
+    }
+}
+
+static int test_poll_tick(C8_Backend* backend, uint32_t* keys) {
+    polledI[pollCount] = c8.I;
+    return ++pollCount == 3 ? -2 : -1;
+}
+
+static int test_skip_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    renderedI[renderCount] = c8.I;
+    if (++renderCount == 3) {
+        c8.running = 0;
+    }
+    return 0;
+}
+
+/* Run ADD I, V0; JP 0x200 uncapped until 3 frames are rendered */
+static void simulate_uncapped(void) {
+    C8_Backend backend = { 0 };
+    backend.name       = "skip";
+    backend.render     = test_skip_render;
+    TEST_ASSERT_EQUAL_INT(0, c8_register_backend(&backend));
+    TEST_ASSERT_EQUAL_INT(0, c8_init_graphics(&c8, "skip", 0));
+
+    c8.tickSpeed              = C8_TICK_SPEED;
+    c8.dt                     = 255;
+    c8.V[0]                   = 1;
+    c8.mem[C8_PROG_START]     = 0xF0; // ADD I, V0
+    c8.mem[C8_PROG_START + 1] = 0x1E;
+    c8.mem[C8_PROG_START + 2] = 0x12; // JP 0x200
+    c8.mem[C8_PROG_START + 3] = 0x00;
+    renderCount               = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, c8_simulate(&c8));
+    TEST_ASSERT_EQUAL_INT(3, renderCount);
+    c8_deinit_graphics(&c8);
+}
 
 void setUp(void) { memset(&c8, 0, sizeof(c8)); }
 
@@ -114,6 +170,253 @@ void test_c8_load_rom_WhereFileDoesNotExist(void) {
     TEST_ASSERT_EQUAL_INT(C8_IO_EXCEPTION, result);
 }
 
+void test_c8_reset_RestoresLoadedImage(void) {
+    C8*       c8_allocd = c8_init(get_path("1dcell.ch8"), 0);
+    C8_Config cfg;
+    uint8_t   mem[C8_MEMSIZE];
+
+    c8_get_config(c8_allocd, &cfg);
+    memcpy(mem, c8_allocd->mem, C8_MEMSIZE);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT(C8_PROG_START + 150, cfg.memUsed);
+
+    c8_allocd->mem[0xFFF]         = 1;
+    c8_allocd->mem[0x201]        ^= 0xFF;
+    c8_allocd->V[3]               = 4;
+    c8_allocd->sp                 = 2;
+    c8_allocd->pc                 = 0x300;
+    c8_allocd->keys               = C8_KEY_BIT(5);
+    c8_allocd->display.p[5]       = 1;
+    c8_allocd->display.mode       = C8_DISPLAYMODE_HIGH;
+    c8_allocd->tickSpeed          = 1;
+    c8_allocd->breakpoints[0x200] = 1;
+
+    TEST_ASSERT_EQUAL_INT(0, c8_reset(c8_allocd, &cfg));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(mem, c8_allocd->mem, C8_MEMSIZE));
+    TEST_ASSERT_EQUAL_INT(0, c8_allocd->V[3]);
+    TEST_ASSERT_EQUAL_INT(0, c8_allocd->sp);
+    TEST_ASSERT_EQUAL_INT(C8_PROG_START, c8_allocd->pc);
+    TEST_ASSERT_EQUAL_HEX32(0, c8_allocd->keys);
+    TEST_ASSERT_EQUAL_INT(0, c8_allocd->display.p[5]);
+    TEST_ASSERT_EQUAL_INT(C8_DISPLAYMODE_LOW, c8_allocd->display.mode);
+    TEST_ASSERT_EQUAL_INT(C8_TICK_SPEED, c8_allocd->tickSpeed);
+    TEST_ASSERT_EQUAL_INT(1, c8_allocd->breakpoints[0x200]);
+    free(c8_allocd);
+}
+
+void test_c8_reset_WithNullConfig(void) {
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_reset(&c8, NULL));
+}
+
+void test_c8_run_frame_ExecutesOneFrame(void) {
+    c8.pc        = C8_PROG_START;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.running   = 1;
+    c8.dt        = 2;
+    for (int i = 0; i < 32; i += 2) {
+        c8.mem[C8_PROG_START + i]     = 0x70; // ADD V0, 1
+        c8.mem[C8_PROG_START + i + 1] = 0x01;
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(C8_TICK_SPEED / 60, c8.V[0]);
+    TEST_ASSERT_EQUAL_INT(C8_PROG_START + C8_TICK_SPEED / 60 * 2, c8.pc);
+    TEST_ASSERT_EQUAL_INT(1, c8.dt);
+}
+
+void test_c8_run_frame_AppliesInputAtInstruction(void) {
+    /* LD V0, K; ADD V1, 1; JP 0x202 */
+    const uint8_t program[] = { 0xF0, 0x0A, 0x71, 0x01, 0x12, 0x02 };
+
+    memcpy(&c8.mem[C8_PROG_START], program, sizeof(program));
+    c8.pc        = C8_PROG_START;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.running   = 1;
+
+    /* Released half way through the frame, at the 7th of 12 instructions */
+    c8_input_push(&c8.input, 5, 1, 0.25 / 60);
+    c8_input_push(&c8.input, 5, 0, 0.5 / 60);
+
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(5, c8.V[0]);
+    TEST_ASSERT_EQUAL_INT(3, c8.V[1]);
+    TEST_ASSERT_EQUAL_HEX32(0, c8.keys);
+    TEST_ASSERT_EQUAL_INT(0, c8.waitingForKey);
+}
+
+void test_c8_run_frame_BudgetsCycles(void) {
+    const C8_CycleModel* model;
+
+    c8.pc        = C8_PROG_START;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.flags     = C8_FLAG_CYCLES;
+    c8.running   = 1;
+    c8.V[0]      = 1;
+    for (int i = 0; i < 512; i += 2) {
+        c8.mem[C8_PROG_START + i]     = 0xF0; // ADD I, V0
+        c8.mem[C8_PROG_START + i + 1] = 0x1E;
+    }
+    model = c8_cycle_model(&c8);
+    TEST_ASSERT_NOT_NULL(model);
+
+    int cost = model->cost[C8_OP_ADD_I_VX];
+    TEST_ASSERT_EQUAL_INT(model->frame, c8_frame_cycles(&c8));
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT((model->frame + cost - 1) / cost, c8.I);
+    TEST_ASSERT_EQUAL_INT(model->frame, c8.frameStep);
+}
+
+void test_c8_run_frame_CallsHooks(void) {
+    /* CLS; LD V0, 5; LD ST, V0; LD V1, K */
+    const uint8_t program[] = { 0x00, 0xE0, 0x60, 0x05, 0xF0, 0x18, 0xF1, 0x0A };
+
+    memcpy(&c8.mem[C8_PROG_START], program, sizeof(program));
+    c8.pc        = C8_PROG_START;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.running   = 1;
+    set_hooks();
+
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_DRAW]);
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_SOUND_START]);
+    TEST_ASSERT_EQUAL_INT(5, hookArg[C8_HOOK_SOUND_START]);
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_WAIT_KEY]);
+    TEST_ASSERT_EQUAL_INT(1, hookArg[C8_HOOK_WAIT_KEY]);
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_FRAME]);
+    TEST_ASSERT_EQUAL_INT(0, hookCount[C8_HOOK_SOUND_STOP]);
+
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    }
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_SOUND_STOP]);
+    TEST_ASSERT_EQUAL_INT(5, hookCount[C8_HOOK_FRAME]);
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_WAIT_KEY]);
+}
+
+void test_c8_run_frame_CallsExitAndExceptionHooks(void) {
+    /* EXIT; RET */
+    const uint8_t program[] = { 0x00, 0xFD, 0x00, 0xEE };
+
+    memcpy(&c8.mem[C8_PROG_START], program, sizeof(program));
+    c8.pc        = C8_PROG_START;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.mode      = C8_MODE_SCHIP;
+    c8.running   = 1;
+    set_hooks();
+
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_EXIT]);
+    TEST_ASSERT_EQUAL_INT(0, c8.running);
+
+    c8.pc      = C8_PROG_START + 2;
+    c8.running = 1;
+    TEST_ASSERT_EQUAL_INT(C8_STACK_UNDERFLOW_EXCEPTION, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(1, hookCount[C8_HOOK_EXCEPTION]);
+    TEST_ASSERT_EQUAL_INT(C8_STACK_UNDERFLOW_EXCEPTION, hookArg[C8_HOOK_EXCEPTION]);
+}
+
+void test_c8_set_hook_WithNullHook(void) {
+    set_hooks();
+    TEST_ASSERT_EQUAL_INT(0, c8_set_hook(&c8, C8_HOOK_FRAME, NULL, NULL));
+
+    c8.tickSpeed          = C8_TICK_SPEED;
+    c8.running            = 1;
+    c8.mem[C8_PROG_START] = 0x12; // JP 0x200
+    c8.pc                 = C8_PROG_START;
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(0, hookCount[C8_HOOK_FRAME]);
+}
+
+void test_c8_set_hook_WithInvalidEvent(void) {
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_set_hook(&c8, C8_HOOK_COUNT, test_hook, NULL));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_set_hook(&c8, -1, test_hook, NULL));
+}
+
+void test_c8_run_frame_SeesTapWithinOneInstruction(void) {
+    /* SKP V0; ADD V1, 1; JP 0x204 */
+    const uint8_t program[] = { 0xE0, 0x9E, 0x71, 0x01, 0x12, 0x04 };
+
+    memcpy(&c8.mem[C8_PROG_START], program, sizeof(program));
+    c8.pc        = C8_PROG_START;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.running   = 1;
+    c8.V[0]      = 5;
+
+    /* Pressed and released before the first instruction */
+    c8_input_push(&c8.input, 5, 1, 0.0);
+    c8_input_push(&c8.input, 5, 0, 0.0);
+
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(0, c8.V[1]);
+    TEST_ASSERT_EQUAL_HEX32(0, c8.keys);
+    TEST_ASSERT_NULL(c8_input_peek(&c8.input));
+}
+
+void test_c8_run_frame_SeesEveryRelease(void) {
+    /* LD V0, K; LD V1, K; JP 0x204 */
+    const uint8_t program[] = { 0xF0, 0x0A, 0xF1, 0x0A, 0x12, 0x04 };
+
+    memcpy(&c8.mem[C8_PROG_START], program, sizeof(program));
+    c8.pc        = C8_PROG_START;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.running   = 1;
+
+    /* Two key taps within the same 60 Hz frame */
+    c8_input_push(&c8.input, 3, 1, 0.0);
+    c8_input_push(&c8.input, 3, 0, 1.0 / C8_TICK_SPEED);
+    c8_input_push(&c8.input, 7, 1, 2.0 / C8_TICK_SPEED);
+    c8_input_push(&c8.input, 7, 0, 3.0 / C8_TICK_SPEED);
+
+    TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+    TEST_ASSERT_EQUAL_INT(3, c8.V[0]);
+    TEST_ASSERT_EQUAL_INT(7, c8.V[1]);
+    TEST_ASSERT_EQUAL_INT(C8_PROG_START + 4, c8.pc);
+    TEST_ASSERT_NULL(c8_input_peek(&c8.input));
+}
+
+void test_c8_simulate_PollsInputOncePerFrame(void) {
+    C8_Backend backend = { 0 };
+    backend.name       = "poll";
+    backend.tick       = test_poll_tick;
+    TEST_ASSERT_EQUAL_INT(0, c8_register_backend(&backend));
+    TEST_ASSERT_EQUAL_INT(0, c8_init_graphics(&c8, "poll", 0));
+
+    c8.tickSpeed              = 60000;
+    c8.V[0]                   = 1;
+    c8.mem[C8_PROG_START]     = 0xF0; // ADD I, V0
+    c8.mem[C8_PROG_START + 1] = 0x1E;
+    c8.mem[C8_PROG_START + 2] = 0x12; // JP 0x200
+    c8.mem[C8_PROG_START + 3] = 0x00;
+    pollCount                 = 0;
+
+    TEST_ASSERT_EQUAL_INT(0, c8_simulate(&c8));
+    TEST_ASSERT_EQUAL_INT(3, pollCount);
+    /* Many instructions run between two polls, not one */
+    TEST_ASSERT_GREATER_THAN(polledI[1] + 1, polledI[2]);
+    c8_deinit_graphics(&c8);
+}
+
+void test_c8_simulate_UncappedRendersEveryNthFrame(void) {
+    c8.speed     = C8_SPEED_UNCAPPED;
+    c8.frameSkip = 4;
+    simulate_uncapped();
+
+    /* 12 instructions (6 ADDs) per frame, and one frame in 4 rendered */
+    TEST_ASSERT_EQUAL_INT(24, renderedI[0]);
+    TEST_ASSERT_EQUAL_INT(48, renderedI[1]);
+    TEST_ASSERT_EQUAL_INT(72, renderedI[2]);
+    TEST_ASSERT_EQUAL_INT(255 - 12, c8.dt);
+}
+
+void test_c8_simulate_FastForwardsWhileKeyIsHeld(void) {
+    c8.keys = C8_KEY_BIT(C8_KEY_FAST_FORWARD);
+    simulate_uncapped();
+
+    TEST_ASSERT_EQUAL_INT(6 * C8_FRAME_SKIP, renderedI[0]);
+    TEST_ASSERT_EQUAL_INT(6 * C8_FRAME_SKIP * 3, renderedI[2]);
+    TEST_ASSERT_EQUAL_INT(255 - C8_FRAME_SKIP * 3, c8.dt);
+}
+
 void test_c8_validate_WithValidC8(void) {
     C8* c8_allocd = c8_init(NULL, 0);
     TEST_ASSERT_EQUAL_INT(0, c8_validate(c8_allocd));
@@ -143,6 +446,34 @@ void test_c8_validate_WithInvalidCS(void) {
     free(c8_allocd);
 }
 
+void test_c8_validate_WithInvalidPollRate(void) {
+    C8* c8_allocd = c8_init(NULL, 0);
+
+    c8_allocd->pollRate = -1;
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_STATE_EXCEPTION, c8_validate(c8_allocd));
+
+    free(c8_allocd);
+}
+
+void test_c8_validate_WithInvalidSpeed(void) {
+    C8* c8_allocd = c8_init(NULL, 0);
+
+    c8_allocd->speed = C8_SPEED_MIN - 1;
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_STATE_EXCEPTION, c8_validate(c8_allocd));
+
+    c8_allocd->speed = C8_SPEED_MAX + 1;
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_STATE_EXCEPTION, c8_validate(c8_allocd));
+
+    c8_allocd->speed     = C8_SPEED_UNCAPPED;
+    c8_allocd->frameSkip = -1;
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_STATE_EXCEPTION, c8_validate(c8_allocd));
+
+    c8_allocd->frameSkip = 0;
+    TEST_ASSERT_EQUAL_INT(0, c8_validate(c8_allocd));
+
+    free(c8_allocd);
+}
+
 void test_c8_validate_WithInvalidVK(void) {
     C8* c8_allocd = c8_init(NULL, 0);
 
@@ -297,9 +297,7 @@ void test_c8_save_state_WhereOutputFileIsValid(void) {
         TEST_ASSERT_EQUAL_INT(c8.V[i], loaded_c8.V[i]);
     }
 
-    for (int i = 0; i < 18; i++) {
-        TEST_ASSERT_EQUAL_INT(c8.key[i], loaded_c8.key[i]);
-    }
+    TEST_ASSERT_EQUAL_HEX32(c8.keys, loaded_c8.keys);
 
     for (int i = 0; i < 8; i++) {
         TEST_ASSERT_EQUAL_INT(c8.R[i], loaded_c8.R[i]);
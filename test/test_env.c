@@ -0,0 +1,136 @@
+#include "c8/chip8.h"
+#include "c8/env.h"
+#include "c8/private/exception.h"
+
+#include "unity.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ENVS 64
+#define REWARD_ADDR 0x311
+
+// clang-format off
+const uint16_t program[] = {
+    0xA300, // LD I, 0x300
+    0x6000, // LD V0, 0
+    0xD001, // DRW V0, V0, 1
+    0xF10A, // LD V1, K
+    0xA310, // LD I, 0x310
+    0xF155, // LD [I], V1
+    0x120C, // JP 0x20C
+};
+// clang-format on
+
+C8          c8s[ENVS];
+C8_Env      envs[ENVS];
+C8_EnvBatch batch;
+uint8_t*    buffer;
+
+void setUp(void) {
+    memset(c8s, 0, sizeof(c8s));
+    memset(envs, 0, sizeof(envs));
+    memset(&batch, 0, sizeof(batch));
+    for (int e = 0; e < ENVS; e++) {
+        for (size_t i = 0; i < sizeof(program) / sizeof(program[0]); i++) {
+            c8s[e].mem[0x200 + i * 2]     = program[i] >> 8;
+            c8s[e].mem[0x200 + i * 2 + 1] = program[i] & 0xFF;
+        }
+        c8s[e].mem[0x300] = 0xF0;
+        c8s[e].pc         = C8_PROG_START;
+        c8s[e].tickSpeed  = C8_TICK_SPEED;
+    }
+    buffer = NULL;
+}
+
+void tearDown(void) {
+    c8_env_unbind(&batch);
+    free(buffer);
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_env_bind_WithInvalidParameters(void) {
+    uint8_t obs[sizeof(C8_Observation)];
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_env_bind(&batch, envs, c8s, 0, obs, -1, 0));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_env_bind(&batch, envs, c8s, 1, NULL, -1, 0));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_env_bind(&batch, envs, c8s, 1, obs, C8_MEMSIZE, 0));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_env_batch_step(&batch, NULL));
+}
+
+void test_c8_env_observation_size_WithRam(void) {
+    TEST_ASSERT_EQUAL_INT(sizeof(C8_Observation), c8_env_observation_size(0));
+    TEST_ASSERT_EQUAL_INT(sizeof(C8_Observation) + C8_MEMSIZE,
+                          c8_env_observation_size(C8_ENV_FLAG_OBSERVE_RAM));
+}
+
+void test_c8_env_batch_step_WritesObservations(void) {
+    size_t stride = c8_env_observation_size(C8_ENV_FLAG_OBSERVE_RAM);
+    int    actions[ENVS];
+
+    buffer = malloc(stride * ENVS);
+    TEST_ASSERT_EQUAL_INT(
+        0, c8_env_bind(&batch, envs, c8s, ENVS, buffer, REWARD_ADDR, C8_ENV_FLAG_OBSERVE_RAM));
+
+    /* Hold a different key in every environment; all wait on LD V1, K */
+    for (int e = 0; e < ENVS; e++) {
+        actions[e] = e % 16;
+    }
+    TEST_ASSERT_EQUAL_INT(0, c8_env_batch_step(&batch, actions));
+
+    for (int e = 0; e < ENVS; e++) {
+        const C8_Observation* obs = (const C8_Observation*) (buffer + e * stride);
+        TEST_ASSERT_EQUAL_INT(1, c8s[e].waitingForKey);
+        TEST_ASSERT_EQUAL_INT(0, obs->reward);
+        TEST_ASSERT_EQUAL_INT(0, obs->done);
+        TEST_ASSERT_EQUAL_HEX8(0xF0, obs->frame[0]);
+        TEST_ASSERT_EQUAL_HEX8(0x00, obs->frame[1]);
+    }
+
+    /* Release the keys */
+    TEST_ASSERT_EQUAL_INT(0, c8_env_batch_step(&batch, NULL));
+
+    for (int e = 0; e < ENVS; e++) {
+        const C8_Observation* obs = (const C8_Observation*) (buffer + e * stride);
+        const uint8_t*        ram = (const uint8_t*) (obs + 1);
+        TEST_ASSERT_EQUAL_INT(0, c8s[e].waitingForKey);
+        TEST_ASSERT_EQUAL_INT(e % 16, obs->reward);
+        TEST_ASSERT_EQUAL_HEX8(e % 16, ram[REWARD_ADDR]);
+        TEST_ASSERT_EQUAL_HEX16(0x20C, c8s[e].pc);
+    }
+}
+
+void test_c8_env_batch_step_WhereInstanceFails(void) {
+    uint8_t obs[sizeof(C8_Observation)];
+    c8s[0].mem[0x200] = 0x00;
+    c8s[0].mem[0x201] = 0xEE; // RET with an empty stack
+
+    TEST_ASSERT_EQUAL_INT(0, c8_env_bind(&batch, envs, c8s, 1, obs, -1, 0));
+    TEST_ASSERT_EQUAL_INT(C8_STACK_UNDERFLOW_EXCEPTION, c8_env_batch_step(&batch, NULL));
+    TEST_ASSERT_EQUAL_INT(1, ((C8_Observation*) obs)->done);
+    TEST_ASSERT_EQUAL_INT(0, c8_env_batch_step(&batch, NULL));
+}
+
+void test_c8_env_batch_step_WhereWorkerInstanceFails(void) {
+    size_t stride = c8_env_observation_size(0);
+    int    last   = ENVS - 1;
+
+    buffer = malloc(stride * ENVS);
+    c8s[last].mem[0x200] = 0x00;
+    c8s[last].mem[0x201] = 0xEE; // RET with an empty stack
+
+    TEST_ASSERT_EQUAL_INT(0, c8_env_bind(&batch, envs, c8s, ENVS, buffer, -1, 0));
+    TEST_ASSERT_EQUAL_INT(C8_STACK_UNDERFLOW_EXCEPTION, c8_env_batch_step(&batch, NULL));
+    TEST_ASSERT_EQUAL_STRING("Environment 63 failed", c8_exception);
+
+    /* The same workers keep stepping the remaining instances */
+    for (int step = 0; step < 8; step++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_env_batch_step(&batch, NULL));
+    }
+    TEST_ASSERT_EQUAL_INT(1, ((C8_Observation*) (buffer + last * stride))->done);
+    TEST_ASSERT_EQUAL_INT(0, ((C8_Observation*) buffer)->done);
+}
+
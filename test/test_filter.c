@@ -0,0 +1,110 @@
+#include "c8/filter.h"
+#include "c8/graphics.h"
+#include "c8/private/exception.h"
+
+#include "unity.h"
+
+#include <string.h>
+
+#define BG 0xFF000000
+#define FG 0xFFFFFFFF
+
+C8_Display display;
+int        colors[2] = { 0x000000, 0xFFFFFF };
+uint32_t   out[C8_HIGH_DISPLAY_WIDTH * 4 * C8_HIGH_DISPLAY_HEIGHT * 4];
+
+void setUp(void) {
+    memset(&display, 0, sizeof(C8_Display));
+    memset(out, 0, sizeof(out));
+}
+
+void tearDown(void) {
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+static uint32_t pixel(int scale, int x, int y) {
+    return out[y * C8_LOW_DISPLAY_WIDTH * scale + x];
+}
+
+void test_c8_filter_scale(void) {
+    TEST_ASSERT_EQUAL_INT(1, c8_filter_scale(C8_FILTER_NONE));
+    TEST_ASSERT_EQUAL_INT(2, c8_filter_scale(C8_FILTER_SCALE2X));
+    TEST_ASSERT_EQUAL_INT(3, c8_filter_scale(C8_FILTER_SCALE3X));
+    TEST_ASSERT_EQUAL_INT(4, c8_filter_scale(C8_FILTER_SCALE4X));
+    TEST_ASSERT_EQUAL_INT(2, c8_filter_scale(C8_FILTER_HQ2X));
+    TEST_ASSERT_EQUAL_INT(0, c8_filter_scale(0x500));
+}
+
+void test_c8_get_filter(void) {
+    TEST_ASSERT_EQUAL_INT(C8_FILTER_NONE, c8_get_filter("none"));
+    TEST_ASSERT_EQUAL_INT(C8_FILTER_SCALE3X, c8_get_filter("scale3x"));
+    TEST_ASSERT_EQUAL_INT(C8_FILTER_HQ2X, c8_get_filter("hq2x"));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_get_filter("xbr"));
+}
+
+void test_c8_display_filter_Scale2xSmoothsDiagonal(void) {
+    int pitch = C8_LOW_DISPLAY_WIDTH * 2 * sizeof(uint32_t);
+
+    /* Pixels at (1,0) and (0,1): the corner of (0,0) between them is filled */
+    display.p[1]                    = 1;
+    display.p[C8_LOW_DISPLAY_WIDTH] = 1;
+    TEST_ASSERT_EQUAL_INT(
+        0, c8_display_filter(&display, colors, C8_FILTER_SCALE2X, out, pitch, 0, 32));
+    TEST_ASSERT_EQUAL_HEX32(BG, pixel(2, 0, 0));
+    TEST_ASSERT_EQUAL_HEX32(BG, pixel(2, 1, 0));
+    TEST_ASSERT_EQUAL_HEX32(BG, pixel(2, 0, 1));
+    TEST_ASSERT_EQUAL_HEX32(FG, pixel(2, 1, 1));
+    TEST_ASSERT_EQUAL_HEX32(FG, pixel(2, 2, 0));
+    TEST_ASSERT_EQUAL_HEX32(BG, pixel(2, 4, 0));
+}
+
+void test_c8_display_filter_Hq2xBlendsDiagonal(void) {
+    int pitch = C8_LOW_DISPLAY_WIDTH * 2 * sizeof(uint32_t);
+
+    display.p[1]                    = 1;
+    display.p[C8_LOW_DISPLAY_WIDTH] = 1;
+    TEST_ASSERT_EQUAL_INT(
+        0, c8_display_filter(&display, colors, C8_FILTER_HQ2X, out, pitch, 0, 32));
+    TEST_ASSERT_EQUAL_HEX32(BG, pixel(2, 0, 0));
+    TEST_ASSERT_EQUAL_HEX32(0xFF7F7F7F, pixel(2, 1, 1));
+}
+
+void test_c8_display_filter_Scale3xKeepsLonePixel(void) {
+    int pitch = C8_LOW_DISPLAY_WIDTH * 3 * sizeof(uint32_t);
+
+    display.p[C8_LOW_DISPLAY_WIDTH + 1] = 1;
+    TEST_ASSERT_EQUAL_INT(
+        0, c8_display_filter(&display, colors, C8_FILTER_SCALE3X, out, pitch, 0, 32));
+    for (int y = 0; y < 9; y++) {
+        for (int x = 0; x < 9; x++) {
+            int lit = x >= 3 && x < 6 && y >= 3 && y < 6;
+            TEST_ASSERT_EQUAL_HEX32(lit ? FG : BG, pixel(3, x, y));
+        }
+    }
+}
+
+void test_c8_display_filter_OnlyWritesRequestedRows(void) {
+    int pitch = C8_LOW_DISPLAY_WIDTH * 4 * sizeof(uint32_t);
+
+    display.p[2 * C8_LOW_DISPLAY_WIDTH] = 1;
+    TEST_ASSERT_EQUAL_INT(
+        0, c8_display_filter(&display, colors, C8_FILTER_SCALE4X, out, pitch, 2, 1));
+    TEST_ASSERT_EQUAL_HEX32(FG, pixel(4, 0, 0));
+    TEST_ASSERT_EQUAL_HEX32(FG, pixel(4, 2, 2));
+    TEST_ASSERT_EQUAL_HEX32(BG, pixel(4, 3, 3));
+    TEST_ASSERT_EQUAL_HEX32(BG, pixel(4, 4, 0));
+    TEST_ASSERT_EQUAL_HEX32(0, pixel(4, 0, 4));
+}
+
+void test_c8_display_filter_WithInvalidParameters(void) {
+    int pitch = C8_LOW_DISPLAY_WIDTH * 2 * sizeof(uint32_t);
+
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_display_filter(&display, colors, 0x500, out, pitch, 0, 32));
+    TEST_ASSERT_EQUAL_INT(
+        C8_INVALID_PARAMETER_EXCEPTION,
+        c8_display_filter(&display, colors, C8_FILTER_SCALE4X, out, pitch, 0, 32));
+    TEST_ASSERT_EQUAL_INT(
+        C8_INVALID_PARAMETER_EXCEPTION,
+        c8_display_filter(&display, colors, C8_FILTER_SCALE2X, out, pitch, 30, 3));
+}
@@ -1,14 +1,28 @@
 #include "c8/chip8.h"
 #include "c8/graphics.h"
+#include "c8/private/exception.h"
 
 #include "unity.h"
 
 #include <string.h>
 
 C8   c8;
+int  renders;
 
-void setUp(void) { memset(&c8, 0, sizeof(C8)); }
-void tearDown(void) {}
+void setUp(void) {
+    memset(&c8, 0, sizeof(C8));
+    renders = 0;
+}
+
+void tearDown(void) {
+    c8_deinit_graphics(&c8);
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+static int test_render(C8_Backend* backend, C8_Display* display, int* colors) {
+    renders += *(int*) backend->ctx;
+    return 0;
+}
 
 void test_c8_get_pixel_withLowDisplayMode(void) {
     c8.display.mode = C8_DISPLAYMODE_LOW;
@@ -21,3 +35,128 @@ void test_c8_get_pixel_withHighDisplayMode(void) {
     c8.display.p[0] = 1;
     TEST_ASSERT_EQUAL_INT(1, *c8_get_pixel(&c8.display, 0, 0));
 }
+
+void test_c8_display_pack_withLowDisplayMode(void) {
+    uint8_t out[C8_PACKED_DISPLAY_SIZE];
+    c8.display.mode  = C8_DISPLAYMODE_LOW;
+    c8.display.p[0]  = 1;
+    c8.display.p[9]  = 1;
+    c8.display.p[64] = 1;
+    TEST_ASSERT_EQUAL_INT(256, c8_display_pack(&c8.display, out));
+    TEST_ASSERT_EQUAL_HEX8(0x80, out[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x40, out[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x80, out[8]);
+}
+
+void test_c8_display_to_rgba32_WithScale(void) {
+    uint32_t out[C8_LOW_DISPLAY_WIDTH * 2 * C8_LOW_DISPLAY_HEIGHT * 2];
+    int      colors[2] = { 0x102030, 0xFFA000 };
+    int      pitch     = C8_LOW_DISPLAY_WIDTH * 2 * sizeof(uint32_t);
+
+    c8.display.mode = C8_DISPLAYMODE_LOW;
+    c8.display.p[1] = 1;
+    TEST_ASSERT_EQUAL_INT(0, c8_display_to_rgba32(&c8.display, colors, out, pitch, 2));
+    TEST_ASSERT_EQUAL_HEX32(0xFF102030, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFF102030, out[1]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFA000, out[2]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFA000, out[3]);
+    TEST_ASSERT_EQUAL_HEX32(0xFF102030, out[4]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFA000, out[C8_LOW_DISPLAY_WIDTH * 2 + 3]);
+
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_display_to_rgba32(&c8.display, colors, out, pitch, 0));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_display_to_rgba32(&c8.display, colors, out, pitch, 3));
+}
+
+void test_c8_display_unpack_WithHighDisplayMode(void) {
+    C8_Display display;
+    uint8_t    packed[C8_PACKED_DISPLAY_SIZE] = { 0x41 };
+    c8_display_unpack(&display, packed, C8_DISPLAYMODE_HIGH);
+    TEST_ASSERT_EQUAL_INT(C8_DISPLAYMODE_HIGH, display.mode);
+    TEST_ASSERT_EQUAL_INT(0, display.p[0]);
+    TEST_ASSERT_EQUAL_INT(1, display.p[1]);
+    TEST_ASSERT_EQUAL_INT(1, display.p[7]);
+    TEST_ASSERT_EQUAL_INT(0, display.p[8]);
+}
+
+void test_c8_persistence_update_FadesDarkPixels(void) {
+    C8_Persistence persistence;
+
+    memset(&persistence, 0, sizeof(C8_Persistence));
+    persistence.decay = 128;
+    c8.display.mode   = C8_DISPLAYMODE_HIGH;
+    c8.display.p[0]   = 1;
+    c8.display.p[100] = 1;
+    TEST_ASSERT_EQUAL_INT(1, c8_persistence_update(&persistence, &c8.display));
+    TEST_ASSERT_EQUAL_INT(C8_DISPLAYMODE_HIGH, persistence.mode);
+    TEST_ASSERT_EQUAL_HEX8(0xFF, persistence.i[100]);
+
+    c8.display.p[100] = 0;
+    TEST_ASSERT_EQUAL_INT(1, c8_persistence_update(&persistence, &c8.display));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, persistence.i[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x7F, persistence.i[100]);
+
+    for (int i = 0; i < 8; i++) {
+        c8_persistence_update(&persistence, &c8.display);
+    }
+    TEST_ASSERT_EQUAL_HEX8(0, persistence.i[100]);
+    TEST_ASSERT_EQUAL_INT(0, c8_persistence_update(&persistence, &c8.display));
+}
+
+void test_c8_persistence_to_rgba32_BlendsColors(void) {
+    C8_Persistence persistence;
+    uint32_t       out[C8_LOW_DISPLAY_WIDTH * C8_LOW_DISPLAY_HEIGHT];
+    int            colors[2] = { 0x000010, 0xFF2010 };
+
+    memset(&persistence, 0, sizeof(C8_Persistence));
+    persistence.i[0] = 0xFF;
+    persistence.i[1] = 0x33;
+    TEST_ASSERT_EQUAL_INT(0,
+                          c8_persistence_to_rgba32(&persistence,
+                                                   colors,
+                                                   out,
+                                                   C8_LOW_DISPLAY_WIDTH * sizeof(uint32_t),
+                                                   1));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFF2010, out[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFF330610, out[1]);
+    TEST_ASSERT_EQUAL_HEX32(0xFF000010, out[2]);
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_persistence_to_rgba32(&persistence, colors, out, 4, 1));
+}
+
+void test_c8_get_backend_WithNullName(void) {
+    TEST_ASSERT_NOT_NULL(c8_get_backend(NULL));
+    TEST_ASSERT_NOT_NULL(c8_get_backend("null"));
+    TEST_ASSERT_NULL(c8_get_backend("foo"));
+}
+
+void test_c8_register_backend_WithoutName(void) {
+    C8_Backend backend = { 0 };
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_register_backend(&backend));
+}
+
+void test_c8_init_graphics_WithRegisteredBackend(void) {
+    int        weight  = 3;
+    C8_Backend backend = { 0 };
+    backend.name       = "test";
+    backend.render     = test_render;
+    backend.ctx        = &weight;
+
+    TEST_ASSERT_EQUAL_INT(0, c8_register_backend(&backend));
+    TEST_ASSERT_EQUAL_INT(0, c8_init_graphics(&c8, "test", C8_GRAPHICS_FLAG_HALF_BLOCK));
+    TEST_ASSERT_EQUAL_INT(C8_GRAPHICS_FLAG_HALF_BLOCK, c8.backend->flags);
+
+    TEST_ASSERT_EQUAL_INT(0, c8.backend->render(c8.backend, &c8.display, c8.colors));
+    TEST_ASSERT_EQUAL_INT(-1, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_INT(0, c8.backend->sound_stop(c8.backend));
+    TEST_ASSERT_EQUAL_INT(3, renders);
+
+    TEST_ASSERT_EQUAL_INT(0, c8_deinit_graphics(&c8));
+    TEST_ASSERT_NULL(c8.backend);
+}
+
+void test_c8_init_graphics_WithUnknownBackend(void) {
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_init_graphics(&c8, "foo", 0));
+    TEST_ASSERT_NULL(c8.backend);
+}
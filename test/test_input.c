@@ -0,0 +1,59 @@
+#include "c8/input.h"
+
+#include "unity.h"
+
+#include <string.h>
+
+C8_InputQueue queue;
+
+void setUp(void) { memset(&queue, 0, sizeof(queue)); }
+
+void tearDown(void) {}
+
+void test_c8_input_peek_WhereQueueIsEmpty(void) { TEST_ASSERT_NULL(c8_input_peek(&queue)); }
+
+void test_c8_input_push_KeepsOrder(void) {
+    const C8_InputEvent* e;
+
+    TEST_ASSERT_EQUAL_INT(0, c8_input_push(&queue, 0xA, 1, 1.0));
+    TEST_ASSERT_EQUAL_INT(0, c8_input_push(&queue, 0xA, 0, 2.0));
+
+    e = c8_input_peek(&queue);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_INT(0xA, e->key);
+    TEST_ASSERT_EQUAL_INT(1, e->pressed);
+    TEST_ASSERT_TRUE(e->time == 1.0);
+    c8_input_pop(&queue);
+
+    e = c8_input_peek(&queue);
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_INT(0, e->pressed);
+    c8_input_pop(&queue);
+    TEST_ASSERT_NULL(c8_input_peek(&queue));
+}
+
+void test_c8_input_push_WhereQueueIsFull(void) {
+    for (int i = 0; i < C8_INPUT_QUEUE_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_input_push(&queue, i & 0xF, 1, i));
+    }
+    TEST_ASSERT_EQUAL_INT(1, c8_input_push(&queue, 0, 1, C8_INPUT_QUEUE_SIZE));
+    c8_input_pop(&queue);
+    TEST_ASSERT_EQUAL_INT(0, c8_input_push(&queue, 0, 1, C8_INPUT_QUEUE_SIZE));
+}
+
+void test_c8_input_set_key_KeepsOtherKeys(void) {
+    uint32_t keys = C8_KEY_BIT(3);
+
+    c8_input_set_key(&keys, 0xF, 1);
+    c8_input_set_key(&keys, 17, 1);
+    TEST_ASSERT_EQUAL_HEX32(C8_KEY_BIT(3) | C8_KEY_BIT(0xF) | C8_KEY_BIT(17), keys);
+
+    c8_input_set_key(&keys, 3, 0);
+    c8_input_set_key(&keys, 4, 0);
+    TEST_ASSERT_EQUAL_HEX32(C8_KEY_BIT(0xF) | C8_KEY_BIT(17), keys);
+}
+
+void test_c8_input_time_IsMonotonic(void) {
+    double t = c8_input_time();
+    TEST_ASSERT_TRUE(c8_input_time() >= t);
+}
@@ -1,4 +1,5 @@
 #include "c8/font.h"
+#include "c8/graphics.h"
 #include "c8/private/exception.h"
 #include "c8/private/instruction.h"
 
@@ -689,41 +690,45 @@ void test_c8_parse_instruction_WhereInstructionIsRNDXKK(void) {
 void test_c8_parse_instruction_WhereInstructionIsSKPV_WhereKeyIsPressed(void) {
     AXKK(0xE, x, 0x9E);
 
-    c8.V[x]   = y;
-    c8.key[y] = 1;
+    c8.V[x]  = y;
+    c8.keys = C8_KEY_BIT(y);
 
-    int ret   = c8_parse_instruction(&c8);
+    int ret = c8_parse_instruction(&c8);
     TEST_ASSERT_EQUAL_INT(2, ret);
+    TEST_ASSERT_EQUAL_UINT16(pc + 2, c8.pc);
 }
 
 void test_c8_parse_instruction_WhereInstructionIsSKPV_WhereKeyIsNotPressed(void) {
     AXKK(0xE, x, 0x9E);
 
-    c8.V[x]   = y;
-    c8.key[y] = 0;
+    c8.V[x]  = y;
+    c8.keys = ~C8_KEY_BIT(y);
 
-    int ret   = c8_parse_instruction(&c8);
+    int ret = c8_parse_instruction(&c8);
     TEST_ASSERT_EQUAL_INT(2, ret);
+    TEST_ASSERT_EQUAL_UINT16(pc + 0, c8.pc);
 }
 
 void test_c8_parse_instruction_WhereInstructionIsSKNPV_WhereKeyIsPressed(void) {
     AXKK(0xE, x, 0xA1);
 
-    c8.V[x]   = y;
-    c8.key[y] = 1;
+    c8.V[x]  = y;
+    c8.keys = C8_KEY_BIT(y);
 
-    int ret   = c8_parse_instruction(&c8);
+    int ret = c8_parse_instruction(&c8);
     TEST_ASSERT_EQUAL_INT(2, ret);
+    TEST_ASSERT_EQUAL_UINT16(pc + 0, c8.pc);
 }
 
 void test_c8_parse_instruction_WhereInstructionIsSKNPV_WhereKeyIsNotPressed(void) {
     AXKK(0xE, x, 0xA1);
 
-    c8.V[x]   = y;
-    c8.key[y] = 0;
+    c8.V[x]  = y;
+    c8.keys = ~C8_KEY_BIT(y);
 
-    int ret   = c8_parse_instruction(&c8);
+    int ret = c8_parse_instruction(&c8);
     TEST_ASSERT_EQUAL_INT(2, ret);
+    TEST_ASSERT_EQUAL_UINT16(pc + 2, c8.pc);
 }
 
 void test_c8_parse_instruction_WhereInstructionIsLDXDT(void) {
@@ -771,6 +776,94 @@ void test_c8_parse_instruction_WhereInstructionIsLDSTX(void) {
     TEST_ASSERT_EQUAL_UINT8(y, c8.st);
 }
 
+static int soundPlaying;
+static int soundChanges;
+
+static int test_sound_play(C8_Backend* backend) {
+    soundPlaying = 1;
+    soundChanges++;
+    return 0;
+}
+
+static int test_sound_stop(C8_Backend* backend) {
+    soundPlaying = 0;
+    soundChanges++;
+    return 0;
+}
+
+void test_c8_parse_instruction_WhereInstructionIsLDSTX_StartsAndStopsTone(void) {
+    C8_Backend backend = { 0 };
+    backend.name       = "sound";
+    backend.sound_play = test_sound_play;
+    backend.sound_stop = test_sound_stop;
+    TEST_ASSERT_EQUAL_INT(0, c8_register_backend(&backend));
+    TEST_ASSERT_EQUAL_INT(0, c8_init_graphics(&c8, "sound", 0));
+
+    AXKK(0xF, x, 0x18);
+    c8.V[x]      = 3;
+    soundPlaying = 0;
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(1, soundPlaying);
+
+    c8.V[x] = 0;
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(0, soundPlaying);
+    c8_deinit_graphics(&c8);
+}
+
+void test_c8_parse_instruction_WhereInstructionIsLDSTX_OnlyTogglesToneOnChange(void) {
+    C8_Backend backend = { 0 };
+    backend.name       = "sound";
+    backend.sound_play = test_sound_play;
+    backend.sound_stop = test_sound_stop;
+    TEST_ASSERT_EQUAL_INT(0, c8_register_backend(&backend));
+    TEST_ASSERT_EQUAL_INT(0, c8_init_graphics(&c8, "sound", 0));
+
+    AXKK(0xF, x, 0x18);
+    c8.V[x]      = 0;
+    soundChanges = 0;
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(0, soundChanges);
+
+    c8.V[x] = 3;
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(1, soundChanges);
+    TEST_ASSERT_EQUAL_INT(3, c8.st);
+    c8_deinit_graphics(&c8);
+}
+
+void test_c8_parse_instruction_WhereInstructionIsSND_InCHIP8Mode(void) {
+    INSERT_INSTRUCTION(pc, 0xF002);
+    c8.mode = C8_MODE_CHIP8;
+
+    REDIRECT_STDERR;
+    int ret = c8_parse_instruction(&c8);
+    RESTORE_STDERR;
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_STATE_EXCEPTION, ret);
+    TEST_ASSERT_EQUAL_INT(0, c8.patternSet);
+}
+
+void test_c8_parse_instruction_WhereInstructionIsSND_InXOCHIPMode(void) {
+    INSERT_INSTRUCTION(pc, 0xF002);
+    c8.mode = C8_MODE_XOCHIP;
+
+    int ret = c8_parse_instruction(&c8);
+    TEST_ASSERT_EQUAL_INT(2, ret);
+    TEST_ASSERT_EQUAL_INT(1, c8.patternSet);
+    TEST_ASSERT_EQUAL_MEMORY(&c8.mem[c8.I], c8.pattern, C8_AUDIO_PATTERN_SIZE);
+}
+
+void test_c8_parse_instruction_WhereInstructionIsPITX_InXOCHIPMode(void) {
+    AXKK(0xF, x, 0x3A);
+    c8.mode = C8_MODE_XOCHIP;
+    c8.V[x] = vx;
+
+    int ret = c8_parse_instruction(&c8);
+    TEST_ASSERT_EQUAL_INT(2, ret);
+    TEST_ASSERT_EQUAL_UINT8(vx, c8.pitch);
+}
+
 void test_c8_parse_instruction_WhereInstructionIsADDIX(void) {
     AXKK(0xF, x, 0x1E);
 
@@ -912,3 +1005,69 @@ void test_c8_parse_instruction_WhereInstructionIsLDXR_InSCHIPMode(void) {
         TEST_ASSERT_EQUAL_UINT8(c8.V[i], c8.R[i]);
     }
 }
+
+void test_c8_parse_instruction_WhereInstructionIsDRW_CostsCyclesPerRowAndShift(void) {
+    c8.flags |= C8_FLAG_CYCLES;
+    const C8_CycleModel* model = c8_cycle_model(&c8);
+    TEST_ASSERT_NOT_NULL(model);
+
+    c8.V[x] = 8;
+    AXYB(0xD, x, y, 1);
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(model->cost[C8_OP_DRW_VX_VY_B] + model->drawRow, c8.cycles);
+
+    c8.V[x] = 3;
+    AXYB(0xD, x, y, 5);
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(
+        model->cost[C8_OP_DRW_VX_VY_B] + 5 * (model->drawRow + 3 * model->drawShift), c8.cycles);
+}
+
+void test_c8_parse_instruction_WhereInstructionIsSEXKK_CostsMoreWhenSkipping(void) {
+    c8.flags |= C8_FLAG_CYCLES;
+    const C8_CycleModel* model = c8_cycle_model(&c8);
+
+    c8.V[x] = kk;
+    AXKK(0x3, x, kk);
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(model->cost[C8_OP_SE_VX_KK] + model->skip, c8.cycles);
+
+    c8.pc   = 0x200;
+    c8.V[x] = kk + 1;
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(model->cost[C8_OP_SE_VX_KK], c8.cycles);
+}
+
+void test_c8_cycle_model_WhereFlagIsNotSet(void) {
+    TEST_ASSERT_NULL(c8_cycle_model(&c8));
+}
+
+void test_c8_cycle_model_InXOCHIPMode(void) {
+    c8.flags |= C8_FLAG_CYCLES;
+    c8.mode = C8_MODE_XOCHIP;
+    TEST_ASSERT_NULL(c8_cycle_model(&c8));
+
+    c8.mode = C8_MODE_SCHIP;
+    TEST_ASSERT_NOT_NULL(c8_cycle_model(&c8));
+}
+
+void test_c8_cycle_model_WhereModeIsOutOfRange(void) {
+    c8.flags |= C8_FLAG_CYCLES;
+    c8.mode = 3;
+    TEST_ASSERT_NULL(c8_cycle_model(&c8));
+
+    c8.mode = -1;
+    TEST_ASSERT_NULL(c8_cycle_model(&c8));
+}
+
+void test_c8_parse_instruction_WhereFlagIsNotSet_CostsNoCycles(void) {
+    c8.V[x] = kk;
+    AXKK(0x3, x, kk);
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(0, c8.cycles);
+
+    c8.pc = 0x200;
+    AXYB(0xD, x, y, 5);
+    TEST_ASSERT_EQUAL_INT(2, c8_parse_instruction(&c8));
+    TEST_ASSERT_EQUAL_INT(0, c8.cycles);
+}
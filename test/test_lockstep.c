@@ -0,0 +1,176 @@
+#include "c8/chip8.h"
+#include "c8/lockstep.h"
+#include "c8/private/exception.h"
+#include "c8/private/instruction.h"
+
+#include "unity.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define LANES 5
+
+// clang-format off
+const uint16_t program[] = {
+    0x6005, // LD V0, 5
+    0x7103, // ADD V1, 3
+    0x8014, // ADD V0, V1
+    0x3008, // SE V0, 8
+    0x6A01, // LD VA, 1
+    0xA300, // LD I, 0x300
+    0xF01E, // ADD I, V0
+    0xF033, // LD B, V0
+    0x8106, // SHR V1, V0
+    0x1202, // JP 0x202
+};
+// clang-format on
+
+C8          c8;
+C8          ref[LANES];
+C8_Lockstep ls;
+
+void setUp(void) {
+    memset(&c8, 0, sizeof(c8));
+    for (size_t i = 0; i < sizeof(program) / sizeof(program[0]); i++) {
+        c8.mem[0x200 + i * 2]     = program[i] >> 8;
+        c8.mem[0x200 + i * 2 + 1] = program[i] & 0xFF;
+    }
+    c8.pc = C8_PROG_START;
+}
+
+void tearDown(void) {
+    c8_lockstep_deinit(&ls);
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_lockstep_init_WithInvalidCount(void) {
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_lockstep_init(&ls, &c8, 0));
+}
+
+void test_c8_lockstep_step_MatchesScalarExecution(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_lockstep_init(&ls, &c8, LANES));
+
+    for (int l = 0; l < LANES; l++) {
+        ref[l]                   = c8;
+        ref[l].V[1]              = l;
+        C8_LOCKSTEP_V(&ls, 1)[l] = l;
+    }
+
+    for (int step = 0; step < 100; step++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_lockstep_step(&ls));
+        for (int l = 0; l < LANES; l++) {
+            int ret = c8_parse_instruction(&ref[l]);
+            TEST_ASSERT_GREATER_THAN_INT(-1, ret);
+            ref[l].pc += ret;
+        }
+    }
+
+    for (int l = 0; l < LANES; l++) {
+        C8* lane = c8_lockstep_sync(&ls, l);
+        TEST_ASSERT_EQUAL_INT(ref[l].pc, lane->pc);
+        TEST_ASSERT_EQUAL_INT(ref[l].I, lane->I);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(ref[l].V, lane->V, 16));
+        TEST_ASSERT_EQUAL_INT(0, memcmp(ref[l].mem, lane->mem, C8_MEMSIZE));
+    }
+}
+
+void test_c8_lockstep_step_MatchesScalarAluOperations(void) {
+    const int     ops[]   = { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE };
+    const int     regs[]  = { 0x01, 0xF1, 0x2F, 0x33 }; // xy pairs, including VF
+    const int     flags[] = { 0, C8_FLAG_QUIRK_VF_RESET, C8_FLAG_QUIRK_SHIFTING };
+    const uint8_t vals[]  = { 0x00, 0x01, 0x7F, 0x80, 0xFF };
+
+    for (size_t o = 0; o < sizeof(ops) / sizeof(ops[0]); o++) {
+        for (size_t r = 0; r < sizeof(regs) / sizeof(regs[0]); r++) {
+            for (size_t q = 0; q < sizeof(flags) / sizeof(flags[0]); q++) {
+                uint16_t in = 0x8000 | regs[r] << 4 | ops[o];
+                c8.mem[0x200] = in >> 8;
+                c8.mem[0x201] = in & 0xFF;
+                c8.flags      = flags[q];
+                TEST_ASSERT_EQUAL_INT(0, c8_lockstep_init(&ls, &c8, LANES));
+
+                for (int l = 0; l < LANES; l++) {
+                    ref[l] = c8;
+                    for (int i = 0; i < 16; i++) {
+                        ref[l].V[i]              = vals[(l + i) % LANES] ^ i;
+                        C8_LOCKSTEP_V(&ls, i)[l] = ref[l].V[i];
+                    }
+                }
+
+                TEST_ASSERT_EQUAL_INT(0, c8_lockstep_step(&ls));
+                for (int l = 0; l < LANES; l++) {
+                    ref[l].pc += c8_parse_instruction(&ref[l]);
+                    C8* lane = c8_lockstep_sync(&ls, l);
+                    TEST_ASSERT_EQUAL_INT(ref[l].pc, lane->pc);
+                    TEST_ASSERT_EQUAL_INT(0, memcmp(ref[l].V, lane->V, 16));
+                }
+                c8_lockstep_deinit(&ls);
+            }
+        }
+    }
+}
+
+void test_c8_lockstep_step_WhereLaneRewritesItsCode(void) {
+    // clang-format off
+    const uint16_t smc[] = {
+        0xA206, // LD I, 0x206
+        0xF155, // LD [I], V1 (rewrites 0x206 with V0, V1)
+        0x6B02, // LD VB, 2
+        0x6A09, // LD VA, 9
+        0x1208, // JP 0x208
+    };
+    // clang-format on
+
+    for (size_t i = 0; i < sizeof(smc) / sizeof(smc[0]); i++) {
+        c8.mem[0x200 + i * 2]     = smc[i] >> 8;
+        c8.mem[0x200 + i * 2 + 1] = smc[i] & 0xFF;
+    }
+    TEST_ASSERT_EQUAL_INT(0, c8_lockstep_init(&ls, &c8, LANES));
+
+    /* Lane l turns 0x206 into LD VA, l */
+    for (int l = 0; l < LANES; l++) {
+        ref[l]                   = c8;
+        ref[l].V[0]              = 0x6A;
+        ref[l].V[1]              = l;
+        C8_LOCKSTEP_V(&ls, 0)[l] = 0x6A;
+        C8_LOCKSTEP_V(&ls, 1)[l] = l;
+    }
+
+    for (int step = 0; step < 5; step++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_lockstep_step(&ls));
+        for (int l = 0; l < LANES; l++) {
+            ref[l].pc += c8_parse_instruction(&ref[l]);
+        }
+    }
+
+    for (int l = 0; l < LANES; l++) {
+        C8* lane = c8_lockstep_sync(&ls, l);
+        TEST_ASSERT_EQUAL_INT(l, lane->V[0xA]);
+        TEST_ASSERT_EQUAL_INT(ref[l].pc, lane->pc);
+        TEST_ASSERT_EQUAL_INT(0, memcmp(ref[l].V, lane->V, 16));
+    }
+}
+
+void test_c8_lockstep_tick(void) {
+    c8.dt = 2;
+    c8.st = 1;
+    TEST_ASSERT_EQUAL_INT(0, c8_lockstep_init(&ls, &c8, 2));
+
+    c8_lockstep_tick(&ls);
+    c8_lockstep_tick(&ls);
+    TEST_ASSERT_EQUAL_INT(0, ls.dt[1]);
+    TEST_ASSERT_EQUAL_INT(0, ls.st[1]);
+}
+
+void test_c8_lockstep_key_released(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_lockstep_init(&ls, &c8, 2));
+    ls.lanes[1].waitingForKey = 1;
+    ls.lanes[1].VK            = 3;
+
+    c8_lockstep_step(&ls);
+    TEST_ASSERT_EQUAL_INT(0x200, ls.pc[1]);
+
+    c8_lockstep_key_released(&ls, 1, 0xB);
+    TEST_ASSERT_EQUAL_INT(0xB, C8_LOCKSTEP_V(&ls, 3)[1]);
+    TEST_ASSERT_EQUAL_INT(0, ls.lanes[1].waitingForKey);
+}
@@ -0,0 +1,93 @@
+#include "c8/chip8.h"
+#include "c8/graphics.h"
+#include "c8/offscreen.h"
+#include "c8/private/exception.h"
+
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SCRIPT_PATH "offscreen_script.txt"
+#define DUMP_PREFIX "offscreen_frame"
+
+C8            c8;
+C8_Offscreen* off;
+
+static void write_file(const char* path, const char* s) {
+    FILE* f = fopen(path, "w");
+    fputs(s, f);
+    fclose(f);
+}
+
+void setUp(void) {
+    memset(&c8, 0, sizeof(C8));
+    c8_init_graphics(&c8, "offscreen", 0);
+    off = c8_offscreen(&c8);
+}
+
+void tearDown(void) {
+    c8_deinit_graphics(&c8);
+    remove(SCRIPT_PATH);
+    remove(DUMP_PREFIX "000000.pgm");
+    remove(DUMP_PREFIX "000002.pgm");
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_offscreen_WhereBackendIsNotOffscreen(void) {
+    C8 other;
+    memset(&other, 0, sizeof(C8));
+    TEST_ASSERT_NOT_NULL(off);
+    TEST_ASSERT_NULL(c8_offscreen(&other));
+}
+
+void test_c8_offscreen_render_KeepsAndDumpsFrames(void) {
+    char  header[16] = { 0 };
+    FILE* f;
+
+    off->dumpPrefix = DUMP_PREFIX;
+    off->dumpEvery  = 2;
+    off->dumpFormat = C8_OFFSCREEN_PGM;
+    c8.display.p[1] = 1;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(0, c8.backend->render(c8.backend, &c8.display, c8.colors));
+    }
+    TEST_ASSERT_EQUAL_INT(3, off->frameCount);
+    TEST_ASSERT_EQUAL_INT(1, off->frame.p[1]);
+
+    TEST_ASSERT_NULL(fopen(DUMP_PREFIX "000001.pgm", "rb"));
+    f = fopen(DUMP_PREFIX "000002.pgm", "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL_INT(13, fread(header, 1, 13, f));
+    TEST_ASSERT_EQUAL_STRING("P5\n64 32\n255\n", header);
+    TEST_ASSERT_EQUAL_INT(0x00, fgetc(f));
+    TEST_ASSERT_EQUAL_INT(0xFF, fgetc(f));
+    fclose(f);
+}
+
+void test_c8_offscreen_load_script_AppliesEventsByFrame(void) {
+    write_file(SCRIPT_PATH, "# test\n0 5 down\n\n1 5 up\n1 a down\n2 quit\n");
+    TEST_ASSERT_EQUAL_INT(0, c8_offscreen_load_script(off, SCRIPT_PATH));
+    TEST_ASSERT_EQUAL_INT(4, off->eventCount);
+
+    TEST_ASSERT_EQUAL_INT(-1, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_HEX32(C8_KEY_BIT(5), c8.keys);
+
+    c8.backend->render(c8.backend, &c8.display, c8.colors);
+    TEST_ASSERT_EQUAL_INT(5, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_INT(-1, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_HEX32(C8_KEY_BIT(0xA), c8.keys);
+
+    c8.backend->render(c8.backend, &c8.display, c8.colors);
+    TEST_ASSERT_EQUAL_INT(-2, c8.backend->tick(c8.backend, &c8.keys));
+}
+
+void test_c8_offscreen_load_script_WithInvalidScript(void) {
+    write_file(SCRIPT_PATH, "0 5 sideways\n");
+    TEST_ASSERT_EQUAL_INT(C8_SYNTAX_ERROR_EXCEPTION, c8_offscreen_load_script(off, SCRIPT_PATH));
+
+    write_file(SCRIPT_PATH, "2 5 down\n1 5 up\n");
+    TEST_ASSERT_EQUAL_INT(C8_SYNTAX_ERROR_EXCEPTION, c8_offscreen_load_script(off, SCRIPT_PATH));
+
+    TEST_ASSERT_EQUAL_INT(C8_IO_EXCEPTION, c8_offscreen_load_script(off, "non_existent.txt"));
+}
@@ -0,0 +1,139 @@
+#include "c8/chip8.h"
+#include "c8/pool.h"
+#include "c8/private/exception.h"
+
+#include "unity.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+C8      c8;
+C8_Pool pool;
+
+void setUp(void) {
+    memset(&c8, 0, sizeof(c8));
+    memset(&pool, 0, sizeof(pool));
+}
+
+void tearDown(void) {
+    c8_pool_deinit(&pool);
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_pool_init_WithInvalidSize(void) {
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_pool_init(&pool, 0));
+}
+
+void test_c8_pool_acquire_IsAligned(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 3));
+
+    for (int i = 0; i < 3; i++) {
+        C8* c8_acquired = c8_pool_acquire(&pool);
+        TEST_ASSERT_EQUAL_INT(0, (uintptr_t) c8_acquired % C8_POOL_ALIGNMENT);
+        TEST_ASSERT_EQUAL_INT(0, c8_acquired->pc);
+    }
+}
+
+void test_c8_pool_acquire_GrowsWhenExhausted(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 2));
+
+    C8* a = c8_pool_acquire(&pool);
+    C8* b = c8_pool_acquire(&pool);
+    TEST_ASSERT_EQUAL_PTR((char*) a + pool.stride, b);
+    TEST_ASSERT_EQUAL_INT(1, pool.slabCount);
+
+    C8* c = c8_pool_acquire(&pool);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_EQUAL_INT(2, pool.slabCount);
+    TEST_ASSERT_EQUAL_INT(4, pool.size);
+}
+
+void test_c8_pool_release_ReusesInstance(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 2));
+
+    C8* a = c8_pool_acquire(&pool);
+    c8_pool_acquire(&pool);
+    c8_pool_release(&pool, a);
+    TEST_ASSERT_EQUAL_PTR(a, c8_pool_acquire(&pool));
+    TEST_ASSERT_EQUAL_INT(1, pool.slabCount);
+}
+
+void test_c8_pool_release_WhenReleasedTwice(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 2));
+
+    C8* a = c8_pool_acquire(&pool);
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_release(&pool, a));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_pool_release(&pool, a));
+    TEST_ASSERT_EQUAL_PTR(a, c8_pool_acquire(&pool));
+    TEST_ASSERT_TRUE(a != c8_pool_acquire(&pool));
+}
+
+void test_c8_pool_release_WithForeignInstance(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 2));
+    C8* a = c8_pool_acquire(&pool);
+
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION, c8_pool_release(&pool, &c8));
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_PARAMETER_EXCEPTION,
+                          c8_pool_release(&pool, (C8*) ((char*) a + pool.stride)));
+    TEST_ASSERT_EQUAL_INT(0, pool.freeCount);
+}
+
+void test_c8_pool_release_ClearsBackendAndHooks(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 1));
+
+    C8* a                       = c8_pool_acquire(&pool);
+    a->backend                  = (C8_Backend*) &c8;
+    a->hooks.fn[C8_HOOK_FRAME]  = (C8_Hook) setUp;
+    a->hooks.data[C8_HOOK_DRAW] = &c8;
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_release(&pool, a));
+
+    C8* clone = c8_clone(&c8, &pool);
+    TEST_ASSERT_EQUAL_PTR(a, clone);
+    TEST_ASSERT_NULL(clone->backend);
+    TEST_ASSERT_NULL(clone->hooks.fn[C8_HOOK_FRAME]);
+    TEST_ASSERT_NULL(clone->hooks.data[C8_HOOK_DRAW]);
+}
+
+void test_c8_pool_release_ClearsBreakpoints(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 1));
+
+    C8* a                 = c8_pool_acquire(&pool);
+    a->flags              = C8_FLAG_DEBUG | C8_FLAG_VERBOSE;
+    a->breakpoints[0x204] = 1;
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_release(&pool, a));
+
+    C8* b = c8_pool_acquire(&pool);
+    TEST_ASSERT_EQUAL_PTR(a, b);
+    TEST_ASSERT_EQUAL_INT(C8_FLAG_VERBOSE, b->flags);
+    TEST_ASSERT_EQUAL_INT(0, b->breakpoints[0x204]);
+}
+
+void test_c8_clone_FromPool(void) {
+    TEST_ASSERT_EQUAL_INT(0, c8_pool_init(&pool, 1));
+    c8.mem[0x200]         = 0x12;
+    c8.V[4]               = 7;
+    c8.pc                 = 0x204;
+    c8.display.p[100]     = 1;
+    c8.colors[1]          = 0xFFFFFF;
+    c8.mode               = C8_MODE_SCHIP;
+    c8.breakpoints[0x204] = 1;
+
+    C8* clone             = c8_clone(&c8, &pool);
+    TEST_ASSERT_NOT_NULL(clone);
+    TEST_ASSERT_EQUAL_INT(0x12, clone->mem[0x200]);
+    TEST_ASSERT_EQUAL_INT(7, clone->V[4]);
+    TEST_ASSERT_EQUAL_INT(0x204, clone->pc);
+    TEST_ASSERT_EQUAL_INT(1, clone->display.p[100]);
+    TEST_ASSERT_EQUAL_INT(0xFFFFFF, clone->colors[1]);
+    TEST_ASSERT_EQUAL_INT(C8_MODE_SCHIP, clone->mode);
+    TEST_ASSERT_EQUAL_INT(0, clone->breakpoints[0x204]);
+}
+
+void test_c8_clone_WithoutPool(void) {
+    c8.V[0]   = 3;
+    C8* clone = c8_clone(&c8, NULL);
+    TEST_ASSERT_NOT_NULL(clone);
+    TEST_ASSERT_EQUAL_INT(3, clone->V[0]);
+    free(clone);
+}
@@ -0,0 +1,52 @@
+#include "c8/graphics.h"
+#include "c8/private/render.h"
+
+#include "unity.h"
+
+#include <string.h>
+
+C8_TripleBuffer tb;
+C8_Display      display;
+
+void setUp(void) {
+    c8_triple_buffer_init(&tb);
+    memset(&display, 0, sizeof(display));
+}
+
+void tearDown(void) {}
+
+void test_c8_triple_buffer_acquire_WhereNothingPublished(void) {
+    TEST_ASSERT_NULL(c8_triple_buffer_acquire(&tb));
+}
+
+void test_c8_triple_buffer_acquire_ReturnsNewestFrame(void) {
+    display.p[0] = 1;
+    c8_triple_buffer_publish(&tb, &display);
+    display.p[0] = 2;
+    c8_triple_buffer_publish(&tb, &display);
+
+    const C8_Display* frame = c8_triple_buffer_acquire(&tb);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_INT(2, frame->p[0]);
+    TEST_ASSERT_NULL(c8_triple_buffer_acquire(&tb));
+}
+
+void test_c8_triple_buffer_publish_DoesNotOverwriteAcquiredFrame(void) {
+    display.p[0] = 1;
+    c8_triple_buffer_publish(&tb, &display);
+    const C8_Display* frame = c8_triple_buffer_acquire(&tb);
+
+    for (int i = 2; i < 6; i++) {
+        display.p[0] = i;
+        c8_triple_buffer_publish(&tb, &display);
+    }
+    TEST_ASSERT_EQUAL_INT(1, frame->p[0]);
+    TEST_ASSERT_EQUAL_INT(5, c8_triple_buffer_acquire(&tb)->p[0]);
+}
+
+void test_c8_triple_buffer_take_key_ReturnsReleasedKeyOnce(void) {
+    TEST_ASSERT_EQUAL_INT(-1, c8_triple_buffer_take_key(&tb));
+    tb.released = 0xA;
+    TEST_ASSERT_EQUAL_INT(0xA, c8_triple_buffer_take_key(&tb));
+    TEST_ASSERT_EQUAL_INT(-1, c8_triple_buffer_take_key(&tb));
+}
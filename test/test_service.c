@@ -0,0 +1,88 @@
+#include "c8/chip8.h"
+#include "c8/service.h"
+#include "c8/private/exception.h"
+
+#include "unity.h"
+
+#include <poll.h>
+#include <string.h>
+
+C8          c8;
+C8_Service* service;
+
+/* Wait up to `timeout` ms for `service` to have work */
+static int ready(int timeout) {
+    struct pollfd p = { .fd = service->fd, .events = POLLIN };
+    return poll(&p, 1, timeout);
+}
+
+void setUp(void) {
+    memset(&c8, 0, sizeof(C8));
+    c8.pc                     = C8_PROG_START;
+    c8.tickSpeed              = C8_TICK_SPEED;
+    c8.dt                     = 255;
+    c8.V[0]                   = 1;
+    c8.mem[C8_PROG_START]     = 0xF0; // ADD I, V0
+    c8.mem[C8_PROG_START + 1] = 0x1E;
+    c8.mem[C8_PROG_START + 2] = 0x12; // JP 0x200
+    c8.mem[C8_PROG_START + 3] = 0x00;
+    service                   = NULL;
+}
+
+void tearDown(void) {
+    if (service) {
+        c8_service_close(service);
+    }
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_service_RunsFramesWhenDue(void) {
+    TEST_ASSERT_NOT_NULL(service = c8_service_open(&c8));
+    TEST_ASSERT_EQUAL_INT(1, c8.running);
+
+    TEST_ASSERT_EQUAL_INT(1, ready(1000));
+    TEST_ASSERT_EQUAL_INT(0, c8_service(service));
+    TEST_ASSERT_LESS_THAN_INT(255, c8.dt);
+    TEST_ASSERT_EQUAL_INT((255 - c8.dt) * 6, c8.I);
+}
+
+void test_c8_service_RunsFrameSkipFramesWhenUncapped(void) {
+    c8.speed     = C8_SPEED_UNCAPPED;
+    c8.frameSkip = 4;
+    TEST_ASSERT_NOT_NULL(service = c8_service_open(&c8));
+
+    TEST_ASSERT_EQUAL_INT(1, ready(0));
+    TEST_ASSERT_EQUAL_INT(0, c8_service(service));
+    TEST_ASSERT_EQUAL_INT(255 - 4, c8.dt);
+    TEST_ASSERT_EQUAL_INT(4 * 6, c8.I);
+
+    /* Still readable, so the host comes back for the next batch */
+    TEST_ASSERT_EQUAL_INT(1, ready(0));
+}
+
+void test_c8_service_WakeMakesFdReadable(void) {
+    c8.speed = C8_SPEED_MIN;
+    TEST_ASSERT_NOT_NULL(service = c8_service_open(&c8));
+    TEST_ASSERT_EQUAL_INT(0, ready(0));
+
+    TEST_ASSERT_EQUAL_INT(0, c8_service_wake(service));
+    TEST_ASSERT_EQUAL_INT(1, ready(0));
+    TEST_ASSERT_EQUAL_INT(0, c8_service(service));
+    TEST_ASSERT_EQUAL_INT(255, c8.dt);
+    TEST_ASSERT_EQUAL_INT(0, ready(0));
+}
+
+void test_c8_service_DisarmsWhenStopped(void) {
+    c8.speed = C8_SPEED_UNCAPPED;
+    TEST_ASSERT_NOT_NULL(service = c8_service_open(&c8));
+
+    c8.running = 0;
+    TEST_ASSERT_EQUAL_INT(0, c8_service(service));
+    TEST_ASSERT_EQUAL_INT(255, c8.dt);
+    TEST_ASSERT_EQUAL_INT(0, ready(0));
+}
+
+void test_c8_service_open_WithInvalidC8(void) {
+    c8.tickSpeed = 0;
+    TEST_ASSERT_NULL(c8_service_open(&c8));
+}
@@ -0,0 +1,83 @@
+#include "c8/chip8.h"
+#include "c8/graphics.h"
+#include "c8/private/exception.h"
+#include "c8/shm.h"
+
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+C8      c8;
+C8_Shm* shm;
+C8_Shm* viewer;
+char    name[64];
+
+void setUp(void) {
+    memset(&c8, 0, sizeof(C8));
+    c8.colors[1] = 0xFFFFFF;
+    snprintf(name, sizeof(name), "/libc8_test_%d", (int) getpid());
+    shm    = c8_shm_open(name, C8_SHM_CREATE);
+    viewer = c8_shm_open(name, 0);
+}
+
+void tearDown(void) {
+    c8_deinit_graphics(&c8);
+    c8_shm_close(viewer);
+    c8_shm_close(shm);
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_shm_open_WhereSegmentDoesNotExist(void) {
+    TEST_ASSERT_NOT_NULL(shm);
+    TEST_ASSERT_NOT_NULL(viewer);
+    TEST_ASSERT_NULL(c8_shm_open("/libc8_test_non_existent", 0));
+}
+
+void test_c8_shm_read_ReturnsPublishedFrame(void) {
+    C8_Display display;
+    int        colors[2];
+
+    c8.display.mode   = C8_DISPLAYMODE_HIGH;
+    c8.display.p[130] = 1;
+    c8_shm_publish(shm, &c8.display, c8.colors);
+
+    TEST_ASSERT_EQUAL_INT(0, c8_shm_read(viewer, &display, colors));
+    TEST_ASSERT_EQUAL_INT(1, viewer->seg->frame);
+    TEST_ASSERT_EQUAL_INT(0, viewer->seg->seq & 1);
+    TEST_ASSERT_EQUAL_INT(C8_DISPLAYMODE_HIGH, display.mode);
+    TEST_ASSERT_EQUAL_INT(1, display.p[130]);
+    TEST_ASSERT_EQUAL_INT(0, display.p[129]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFF, colors[1]);
+}
+
+void test_c8_shm_read_WhileFrameIsBeingWritten(void) {
+    C8_Display display;
+    int        colors[2];
+
+    shm->seg->seq = 1;
+    TEST_ASSERT_EQUAL_INT(C8_INVALID_STATE_EXCEPTION, c8_shm_read(viewer, &display, colors));
+}
+
+void test_c8_shm_attach_AppliesViewerKeys(void) {
+    C8_Display display;
+    int        colors[2];
+
+    TEST_ASSERT_EQUAL_INT(0, c8_shm_attach(&c8, shm));
+    TEST_ASSERT_EQUAL_INT(0, c8.backend->render(c8.backend, &c8.display, c8.colors));
+    TEST_ASSERT_EQUAL_INT(0, c8_shm_read(viewer, &display, colors));
+
+    c8_shm_set_keys(viewer, 0x0024);
+    TEST_ASSERT_EQUAL_INT(-1, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_HEX32(C8_KEY_BIT(2) | C8_KEY_BIT(5), c8.keys);
+
+    c8_shm_set_keys(viewer, 0);
+    TEST_ASSERT_EQUAL_INT(2, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_HEX32(C8_KEY_BIT(5), c8.keys);
+    TEST_ASSERT_EQUAL_INT(5, c8.backend->tick(c8.backend, &c8.keys));
+    TEST_ASSERT_EQUAL_HEX32(0, c8.keys);
+
+    viewer->seg->quit = 1;
+    TEST_ASSERT_EQUAL_INT(-2, c8.backend->tick(c8.backend, &c8.keys));
+}
@@ -0,0 +1,109 @@
+#include "c8/chip8.h"
+#include "c8/wav.h"
+#include "c8/private/exception.h"
+
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* 120 samples per frame and 12 instructions per frame: 10 samples per instruction */
+#define RATE     7200
+#define WAV_PATH "wav_test.wav"
+
+C8      c8;
+C8_Wav* wav;
+
+static void load(const uint16_t* program, int count) {
+    for (int i = 0; i < count; i++) {
+        c8.mem[C8_PROG_START + i * 2]     = program[i] >> 8;
+        c8.mem[C8_PROG_START + i * 2 + 1] = program[i] & 0xFF;
+    }
+}
+
+static void run(int frames) {
+    for (int i = 0; i < frames; i++) {
+        TEST_ASSERT_EQUAL_INT(0, c8_run_frame(&c8));
+        TEST_ASSERT_EQUAL_INT(0, c8_wav_end_frame(wav));
+    }
+}
+
+void setUp(void) {
+    memset(&c8, 0, sizeof(C8));
+    c8.pc        = C8_PROG_START;
+    c8.pitch     = C8_AUDIO_DEFAULT_PITCH;
+    c8.tickSpeed = C8_TICK_SPEED;
+    c8.running   = 1;
+    wav          = c8_wav_open(RATE);
+}
+
+void tearDown(void) {
+    c8_deinit_graphics(&c8);
+    c8_wav_close(wav);
+    remove(WAV_PATH);
+    memset(c8_exception, 0, sizeof(c8_exception));
+}
+
+void test_c8_wav_open_WithInvalidRate(void) {
+    TEST_ASSERT_NULL(c8_wav_open(0));
+}
+
+void test_c8_wav_end_frame_PlacesSoundTimerAtInstruction(void) {
+    /* LD V1, 2; LD ST, V1 (second instruction); JP to itself */
+    const uint16_t program[] = { 0x6102, 0xF118, 0x1204 };
+
+    load(program, 3);
+    TEST_ASSERT_EQUAL_INT(0, c8_wav_attach(&c8, wav));
+    run(3);
+
+    TEST_ASSERT_EQUAL_INT(3 * RATE / 60, wav->sampleCount);
+    for (int i = 0; i < 3 * RATE / 60; i++) {
+        /* The tone starts at the second instruction and stops after the second frame */
+        TEST_ASSERT_EQUAL_INT(i >= 10 && i < 240, wav->samples[i] != 0);
+    }
+}
+
+void test_c8_wav_end_frame_PlaysPattern(void) {
+    /* LD I, 0x300; AUDIO; LD V1, 1; LD ST, V1; JP to itself */
+    const uint16_t program[] = { 0xA300, 0xF002, 0x6101, 0xF118, 0x1208 };
+
+    c8.mode = C8_MODE_XOCHIP;
+    memset(&c8.mem[0x300], 0xF0, C8_AUDIO_PATTERN_SIZE);
+    load(program, 5);
+    TEST_ASSERT_EQUAL_INT(0, c8_wav_attach(&c8, wav));
+    run(1);
+
+    /* Each pattern bit lasts 7200 / 4000 samples, 4 high bits then 4 low bits */
+    TEST_ASSERT_EQUAL_INT(0, wav->samples[29]);
+    TEST_ASSERT_EQUAL_INT(C8_AUDIO_VOLUME, wav->samples[30]);
+    TEST_ASSERT_EQUAL_INT(C8_AUDIO_VOLUME, wav->samples[36]);
+    TEST_ASSERT_EQUAL_INT(-C8_AUDIO_VOLUME, wav->samples[38]);
+}
+
+void test_c8_wav_write_WritesHeader(void) {
+    const uint16_t program[] = { 0x1200 };
+    uint8_t        header[44];
+    FILE*          f;
+
+    load(program, 1);
+    TEST_ASSERT_EQUAL_INT(0, c8_wav_attach(&c8, wav));
+    run(2);
+    TEST_ASSERT_EQUAL_INT(0, c8_wav_write(wav, WAV_PATH));
+
+    f = fopen(WAV_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL_INT(44, fread(header, 1, 44, f));
+    fseek(f, 0, SEEK_END);
+    TEST_ASSERT_EQUAL_INT(44 + 2 * RATE / 30, ftell(f));
+    fclose(f);
+
+    TEST_ASSERT_EQUAL_MEMORY("RIFF", header, 4);
+    TEST_ASSERT_EQUAL_MEMORY("WAVEfmt ", header + 8, 8);
+    TEST_ASSERT_EQUAL_MEMORY("data", header + 36, 4);
+    TEST_ASSERT_EQUAL_INT(RATE & 0xFF, header[24]);
+    TEST_ASSERT_EQUAL_INT(RATE >> 8, header[25]);
+}
+
+void test_c8_wav_write_WhereFileIsInvalid(void) {
+    TEST_ASSERT_EQUAL_INT(C8_IO_EXCEPTION, c8_wav_write(wav, "non_existent/out.wav"));
+}
@@ -1,10 +1,18 @@
+#include "c8/capture.h"
 #include "c8/chip8.h"
+#include "c8/filter.h"
 #include "c8/font.h"
+#include "c8/graphics.h"
+#include "c8/offscreen.h"
+#include "c8/shm.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
+static int  capture_format(const char* path);
+static int  parse_speed(const char* s);
 static void usage(const char* argv0);
 
 int         main(int argc, char* argv[]) {
@@ -23,19 +31,75 @@ int         main(int argc, char* argv[]) {
     int   opt;
     char* fontstr           = NULL;
     int   userDefinedQuirks = 0;
+    int   graphicsFlags     = 0;
+    int   filter;
+    int   persistence;
+    int   audioBuffer;
+    int   log2;
+    char* backend           = NULL;
+    char* dumpPrefix        = NULL;
+    int   dumpEvery         = 1;
+    char* script            = NULL;
+    char* record            = NULL;
+    char* shmName           = NULL;
 
     /* Parse args */
-    while ((opt = getopt(argc, argv, "c:df:p:P:q:svV")) != -1) {
+    while ((opt = getopt(argc, argv, "a:b:B:c:Cdf:F:Hi:k:n:o:p:P:q:r:sS:tvVx:X:")) != -1) {
         switch (opt) {
+        case 'a':
+            audioBuffer = atoi(optarg);
+            for (log2 = 6; log2 <= 13 && (1 << log2) != audioBuffer; log2++) {
+            }
+            if (log2 > 13) {
+                usage(argv[0]);
+            }
+            graphicsFlags = (graphicsFlags & ~C8_GRAPHICS_AUDIO_BUFFER_MASK)
+                            | C8_GRAPHICS_AUDIO_BUFFER(log2);
+            break;
+        case 'b':
+            persistence = atoi(optarg);
+            if (persistence < 1 || persistence > 99) {
+                usage(argv[0]);
+            }
+            graphicsFlags = (graphicsFlags & ~C8_GRAPHICS_PERSISTENCE_MASK)
+                            | C8_GRAPHICS_PERSISTENCE(persistence * 256 / 100);
+            break;
+        case 'B':
+            backend = optarg;
+            break;
         case 'c':
             c8->tickSpeed = atoi(optarg);
             break;
+        case 'C':
+            c8->flags |= C8_FLAG_CYCLES;
+            break;
         case 'd':
             c8->flags |= C8_FLAG_DEBUG;
             break;
         case 'f':
             fontstr = optarg;
             break;
+        case 'F':
+            if ((filter = c8_get_filter(optarg)) < 0) {
+                return EXIT_FAILURE;
+            }
+            graphicsFlags = (graphicsFlags & ~C8_FILTER_MASK) | filter;
+            break;
+        case 'H':
+            graphicsFlags |= C8_GRAPHICS_FLAG_HALF_BLOCK;
+            break;
+        case 'i':
+            script = optarg;
+            break;
+        case 'k':
+            c8->pollRate = atoi(optarg);
+            break;
+        case 'n':
+            dumpEvery = atoi(optarg);
+            break;
+        case 'o':
+            dumpPrefix = optarg;
+            break;
         case 'p':
             if (c8_load_palette_f(c8, optarg) != 0) {
                 return EXIT_FAILURE;
@@ -46,9 +110,18 @@ int         main(int argc, char* argv[]) {
                 return EXIT_FAILURE;
             }
             break;
+        case 'r':
+            record = optarg;
+            break;
         case 's':
             c8->mode = C8_MODE_SCHIP;
             break;
+        case 'S':
+            shmName = optarg;
+            break;
+        case 't':
+            c8->flags |= C8_FLAG_RENDER_THREAD;
+            break;
         case 'v':
             c8->flags |= C8_FLAG_VERBOSE;
             break;
@@ -61,6 +134,16 @@ int         main(int argc, char* argv[]) {
         case 'V':
             printf("%s %s\n", argv[0], c8_version());
             return 0;
+        case 'x':
+            if ((c8->speed = parse_speed(optarg)) == 0) {
+                usage(argv[0]);
+            }
+            break;
+        case 'X':
+            if ((c8->frameSkip = atoi(optarg)) < 1) {
+                usage(argv[0]);
+            }
+            break;
         default:
             usage(argv[0]);
         }
@@ -72,11 +155,25 @@ int         main(int argc, char* argv[]) {
         c8_load_quirks(c8, "csjr");
     }
 
-    if (c8_init_graphics()) {
+    if (!backend && (dumpPrefix || script)) {
+        backend = "offscreen";
+    }
+
+    if (c8_init_graphics(c8, backend, graphicsFlags)) {
         free(c8);
         return EXIT_FAILURE;
     }
 
+    C8_Offscreen* off = c8_offscreen(c8);
+    if (off) {
+        off->dumpPrefix = dumpPrefix;
+        off->dumpEvery  = dumpEvery;
+        if (script && c8_offscreen_load_script(off, script) != 0) {
+            c8_deinit(c8);
+            return EXIT_FAILURE;
+        }
+    }
+
     if (fontstr && c8_set_fonts_s(c8, fontstr) != 0) {
         c8_deinit(c8);
         return EXIT_FAILURE;
@@ -87,16 +184,67 @@ int         main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
-    c8_simulate(c8);
+    C8_Capture* cap = NULL;
+    C8_Shm*     shm = NULL;
+    int         ret = EXIT_SUCCESS;
+
+    if (record) {
+        cap = c8_capture_open(record, capture_format(record));
+        if (!cap || c8_capture_attach(c8, cap) != 0) {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if (ret == EXIT_SUCCESS && shmName) {
+        shm = c8_shm_open(shmName, C8_SHM_CREATE);
+        if (!shm || c8_shm_attach(c8, shm) != 0) {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if (ret == EXIT_SUCCESS) {
+        c8_simulate(c8);
+    }
+
+    /* Every exit after opening the capture or segment comes through here */
     c8_deinit(c8);
 
-    return EXIT_SUCCESS;
+    if (shm) {
+        c8_shm_close(shm);
+    }
+
+    if (cap && c8_capture_close(cap) != 0) {
+        ret = EXIT_FAILURE;
+    }
+
+    return ret;
+}
+
+static int capture_format(const char* path) {
+    size_t len = strlen(path);
+    if (len >= 4 && strcmp(path + len - 4, ".y4m") == 0) {
+        return C8_CAPTURE_Y4M;
+    }
+    return C8_CAPTURE_GIF;
+}
+
+/* Multiplier ("0.25" to "16") as a percentage, "max" as uncapped, or 0 if invalid */
+static int parse_speed(const char* s) {
+    if (strcmp(s, "max") == 0) {
+        return C8_SPEED_UNCAPPED;
+    }
+
+    int percent = (int) (atof(s) * 100 + 0.5);
+    return percent >= C8_SPEED_MIN && percent <= C8_SPEED_MAX ? percent : 0;
 }
 
 static void usage(const char* argv0) {
     fprintf(
         stderr,
-        "Usage: %s [-dsvV] [-c clockspeed] [-f small,big] [-p file] [-P colors] [-q quirks] file\n",
+        "Usage: %s [-CdHstvV] [-a samples] [-b percent] [-B backend] [-c clockspeed]\n"
+        "       [-f small,big] [-F filter] [-i script] [-k rate] [-n every] [-o prefix]\n"
+        "       [-p file] [-P colors] [-q quirks] [-r video] [-S name] [-x speed]\n"
+        "       [-X every] file\n",
         argv0);
     exit(EXIT_FAILURE);
 }